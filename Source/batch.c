@@ -0,0 +1,404 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	batch.c - Translates many recorded session files at once
+--
+-- PROGRAM:		batch
+--
+-- FUNCTIONS:	int main(int argc, char *argv[])
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:	October 18, 2026 - substitutions of a pattern file(-p), as in Asn1
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: usage: batch [-j workers] [-o output] [-p pattern file] file or directory...
+-- Every file given, and every file directly inside a directory given, is read as the keys of one session and
+-- translated with libtranslate.a, one translated line per output line. The files are spread over a work stealing
+-- thread pool with one worker per processor(-j to change it). Without -o the output of a file is written next to
+-- it as <file>.out, and files ending in .out are skipped when a directory is read. With -o the output of all files
+-- goes to one file(- for standard output) in the order the files were given, the files of a directory in name
+-- order: each file is translated into an unnamed temporary file, which is appended to the output once every file
+-- before it is done. One worker at a time holds the writer token and appends the files that are in order, without
+-- holding the lock, so the other workers are never held up by a copy.
+-- Apart from the names of the directory being queued, memory use does not depend on the number of files. Files are
+-- read in fixed size chunks, and with -o no more than BATCH_WINDOW files per worker are started ahead of the oldest
+-- one that is not written out yet.
+-- With -p every translated line goes through the substitutions of the pattern file, compiled once and used by
+-- all workers.
+-- The bytes, lines and throughput of each file and of the whole run are printed to stderr.
+--------------------------------------------------------------------------------------------------------------------*/
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "translator.h"
+#include "pool.h"
+#include "subst.h"
+
+#define BATCH_CHUNK		65536	/* bytes read from a file at a time */
+#define BATCH_WINDOW	4		/* files started per worker ahead of the next one written with -o */
+
+/* one file to translate */
+struct job
+{
+	size_t seq;					/* position of the file in the ordered output */
+	char *path;
+	FILE *spool;				/* translated lines waiting for their turn with -o */
+	size_t bytes;
+	size_t lines;
+	double secs;
+	int failed;
+};
+
+static struct
+{
+	FILE *out;					/* ordered output, NULL to write next to each file */
+	struct subst *subst;		/* substitutions of -p, NULL for none */
+	pthread_mutex_t lock;		/* protects everything below */
+	pthread_cond_t turn;		/* signalled when a job is written to out */
+	size_t next_seq;			/* next job written to out */
+	int writing;				/* set while a worker holds the writer token and copies jobs to out */
+	size_t seq;					/* jobs submitted */
+	size_t window;				/* jobs allowed between next_seq and seq */
+	struct job **done;			/* finished jobs waiting for their turn, by seq % window */
+	size_t files, bytes, lines, failed;
+} batch;
+
+static double now_secs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void write_line(struct job *job, FILE *dst, const char *line, size_t len)
+{
+	/* replacements can make a line any length, they go straight to the file */
+	if(batch.subst != NULL)
+		subst_write(batch.subst, line, len, dst);
+	else
+		fwrite(line, 1, len, dst);
+	putc('\n', dst);
+	job->lines++;
+}
+
+/* read the keys of job->path and write its translated lines to dst */
+static void translate_file(struct job *job, FILE *dst)
+{
+	static __thread char buf[BATCH_CHUNK];
+	char line[TR_LINE_SIZE];
+	struct translator tr;
+	size_t used, len;
+	ssize_t n = 0;
+	int fd, ev = TR_NONE;
+
+	if((fd = open(job->path, O_RDONLY)) < 0)
+	{
+		perror(job->path);
+		job->failed = 1;
+		return;
+	}
+
+	translator_init(&tr);
+	while(ev != TR_TERMINATE && ev != TR_ABORT && (n = read(fd, buf, sizeof(buf))) > 0)
+	{
+		job->bytes += n;
+		for(size_t off = 0; off < (size_t)n; off += used)
+		{
+			ev = translator_feed(&tr, buf + off, n - off, &used, line, sizeof(line), &len);
+			if(ev == TR_LINE || ev == TR_TERMINATE)
+				write_line(job, dst, line, len);
+			if(ev == TR_TERMINATE || ev == TR_ABORT)
+				break;
+		}
+	}
+	if(n < 0)
+	{
+		perror(job->path);
+		job->failed = 1;
+	}
+
+	/* a session that was cut off still gets its last line */
+	if(ev != TR_TERMINATE && ev != TR_ABORT && (tr.len > 0 || tr.state == TR_STOPPED))
+	{
+		translator_flush(&tr, line, sizeof(line), &len);
+		write_line(job, dst, line, len);
+	}
+	close(fd);
+}
+
+/* append a spooled job to the ordered output */
+static void write_spool(struct job *job)
+{
+	char buf[BATCH_CHUNK];
+	size_t n;
+
+	rewind(job->spool);
+	while((n = fread(buf, 1, sizeof(buf), job->spool)) > 0)
+		fwrite(buf, 1, n, batch.out);
+	fclose(job->spool);
+}
+
+static void free_job(struct job *job)
+{
+	free(job->path);
+	free(job);
+}
+
+/* pool task: translate one file, then report it and write out whatever is now in order */
+static void run_job(void *arg)
+{
+	struct job *job = arg;
+	double start = now_secs();
+
+	if(batch.out != NULL)
+	{
+		if((job->spool = tmpfile()) == NULL)
+		{
+			perror("tmpfile()");
+			job->failed = 1;
+		}else
+			translate_file(job, job->spool);
+	}else
+	{
+		char *out_path = malloc(strlen(job->path) + 5);
+		FILE *dst;
+
+		sprintf(out_path, "%s.out", job->path);
+		if((dst = fopen(out_path, "w")) == NULL)
+		{
+			perror(out_path);
+			job->failed = 1;
+		}else
+		{
+			translate_file(job, dst);
+			if(fclose(dst) != 0)
+			{
+				perror(out_path);
+				job->failed = 1;
+			}
+		}
+		free(out_path);
+	}
+	job->secs = now_secs() - start;
+
+	pthread_mutex_lock(&batch.lock);
+	fprintf(stderr, "%s: %zu bytes, %zu lines, %.3f s, %.2f MB/s%s\n", job->path, job->bytes, job->lines,
+			job->secs, job->secs > 0 ? job->bytes / job->secs / 1e6 : 0.0, job->failed ? ", failed" : "");
+	batch.files++;
+	batch.bytes += job->bytes;
+	batch.lines += job->lines;
+	batch.failed += job->failed;
+
+	if(batch.out == NULL)
+	{
+		free_job(job);
+		pthread_mutex_unlock(&batch.lock);
+		return;
+	}
+
+	/* the worker holding the writer token copies every job that is in order, the others only leave theirs */
+	batch.done[job->seq % batch.window] = job;
+	if(batch.writing)
+	{
+		pthread_mutex_unlock(&batch.lock);
+		return;
+	}
+	batch.writing = 1;
+	while((job = batch.done[batch.next_seq % batch.window]) != NULL && job->seq == batch.next_seq)
+	{
+		batch.done[batch.next_seq % batch.window] = NULL;
+
+		/* the copy runs without the lock, so the other workers can keep reporting */
+		pthread_mutex_unlock(&batch.lock);
+		if(job->spool != NULL)
+			write_spool(job);
+		free_job(job);
+		pthread_mutex_lock(&batch.lock);
+
+		batch.next_seq++;
+		pthread_cond_broadcast(&batch.turn);
+	}
+	batch.writing = 0;
+	pthread_mutex_unlock(&batch.lock);
+}
+
+/* queue one file, waiting while it would run too far ahead of the ordered output */
+static void submit(struct pool *p, const char *path)
+{
+	struct job *job = calloc(1, sizeof(*job));
+
+	if(job == NULL || (job->path = strdup(path)) == NULL)
+	{
+		perror("malloc()");
+		exit(EXIT_FAILURE);
+	}
+
+	pthread_mutex_lock(&batch.lock);
+	while(batch.out != NULL && batch.seq >= batch.next_seq + batch.window)
+		pthread_cond_wait(&batch.turn, &batch.lock);
+	job->seq = batch.seq++;
+	pthread_mutex_unlock(&batch.lock);
+
+	pool_submit(p, run_job, job);
+}
+
+static int ends_with(const char *s, const char *suffix)
+{
+	size_t n = strlen(s), m = strlen(suffix);
+	return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+/* queue a file, or every regular file directly inside a directory in name order */
+static void submit_path(struct pool *p, const char *path)
+{
+	struct stat st;
+	struct dirent **names;
+	int count;
+
+	if(stat(path, &st) < 0)
+	{
+		perror(path);
+		pthread_mutex_lock(&batch.lock);
+		batch.failed++;
+		pthread_mutex_unlock(&batch.lock);
+		return;
+	}
+	if(!S_ISDIR(st.st_mode))
+	{
+		submit(p, path);
+		return;
+	}
+
+	if((count = scandir(path, &names, NULL, alphasort)) < 0)
+	{
+		perror(path);
+		pthread_mutex_lock(&batch.lock);
+		batch.failed++;
+		pthread_mutex_unlock(&batch.lock);
+		return;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		const char *name = names[i]->d_name;
+		char *file;
+
+		if(name[0] != '.' && !ends_with(name, ".out"))
+		{
+			if((file = malloc(strlen(path) + strlen(name) + 2)) == NULL)
+			{
+				perror("malloc()");
+				exit(EXIT_FAILURE);
+			}
+			sprintf(file, "%s/%s", path, name);
+			if(stat(file, &st) == 0 && S_ISREG(st.st_mode))
+				submit(p, file);
+			free(file);
+		}
+		free(names[i]);
+	}
+	free(names);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	main
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	int main(int argc, char *argv[]);
+--					int argc:		number of command line arguments
+--					char *argv[]:	[-j workers] [-o output] [-p pattern file] file or directory...
+--
+-- RETURNS: EXIT_SUCCESS if every file was translated, EXIT_FAILURE otherwise
+--
+-- NOTES: Queues every file on the pool, waits for them and prints the totals.
+--------------------------------------------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+	static struct pool p;
+	int opt, workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char *out_path = NULL, *subst_path = NULL;
+	double start, secs;
+
+	while((opt = getopt(argc, argv, "j:o:p:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'j':
+				workers = atoi(optarg);
+				break;
+			case 'o':
+				out_path = optarg;
+				break;
+			case 'p':
+				subst_path = optarg;
+				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+	if(optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-j workers] [-o output] [-p pattern file] file or directory...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if(subst_path != NULL && (batch.subst = subst_load(subst_path)) == NULL)
+	{
+		perror(subst_path);
+		return EXIT_FAILURE;
+	}
+
+	pthread_mutex_init(&batch.lock, NULL);
+	pthread_cond_init(&batch.turn, NULL);
+	if(out_path != NULL)
+	{
+		if(strcmp(out_path, "-") == 0)
+			batch.out = stdout;
+		else if((batch.out = fopen(out_path, "w")) == NULL)
+		{
+			perror(out_path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	start = now_secs();
+	pool_start(&p, workers);
+	batch.window = (size_t)p.workers * BATCH_WINDOW;
+	if((batch.done = calloc(batch.window, sizeof(*batch.done))) == NULL)
+	{
+		perror("malloc()");
+		return EXIT_FAILURE;
+	}
+
+	for(int i = optind; i < argc; i++)
+		submit_path(&p, argv[i]);
+	pool_finish(&p);
+	secs = now_secs() - start;
+
+	if(batch.out != NULL && fclose(batch.out) != 0)
+	{
+		perror(out_path);
+		batch.failed++;
+	}
+
+	fprintf(stderr, "%zu files, %zu bytes, %zu lines, %d workers, %.3f s, %.2f MB/s\n", batch.files, batch.bytes,
+			batch.lines, p.workers, secs, secs > 0 ? batch.bytes / secs / 1e6 : 0.0);
+	free(batch.done);
+	subst_free(batch.subst);
+	return batch.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
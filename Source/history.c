@@ -0,0 +1,380 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	history.c - Keeps a bounded, indexed history of the lines submitted by the input process
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void history_init(struct history *h);
+--				void history_add(struct history *h, const char *line, size_t len);
+--				const char *history_recall(struct history *h, size_t back, size_t *len);
+--				const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Every line sent to the translate process is copied into a fixed byte arena that is used as a ring, so no
+-- memory is allocated per line. When the arena or the entry table is full the oldest lines are dropped.
+-- Two indexes sit on top of the ring: an open addressing hash table for exact matches (also used to drop duplicate
+-- lines), and an n-gram index for substring search. Every distinct gram of one, two and three characters of a line
+-- gets a posting in a second fixed ring, and the postings of a gram are linked newest first from its bucket. A
+-- posting is nothing but the position of the previous posting of its gram: the lines post in the order they are
+-- added and are dropped in the same order, so the live postings are always the last pused positions of the ring,
+-- and the line of a posting is found from its position. A link that leads out of them, or to a newer posting that
+-- reused the position, simply ends the list, nothing is unlinked. When the posting ring is full the oldest lines
+-- are dropped as well.
+--------------------------------------------------------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <string.h>
+
+#include "history.h"
+
+#define SLOT(seq)	((uint32_t)((seq) & (HIST_MAX_LINES - 1)))
+
+/* FNV-1a hash of a line */
+static uint32_t hash_line(const char *s, size_t len)
+{
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)s[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* bucket of the gram of n(1 to 3) characters at s, a single character has a bucket of its own */
+static uint32_t gram_of(const char *s, size_t n)
+{
+	const unsigned char *u = (const unsigned char *)s;
+	uint32_t g;
+
+	if(n == 1)
+		return u[0];
+	g = n == 2 ? (1u << 24) | (uint32_t)(u[0] << 8 | u[1]) : (uint32_t)(u[0] << 16 | u[1] << 8 | u[2]);
+	return 256 + ((g * 2654435761u) >> 16) % (HIST_GRAMS - 256);
+}
+
+/* postings written after p, 0 for the newest one, a posting is live while its age is below pused */
+static uint32_t age(struct history *h, uint32_t p)
+{
+	return (h->ppos + HIST_POSTINGS - 1 - p) % HIST_POSTINGS;
+}
+
+/* first posting of the list of gram, or HIST_POSTINGS when the list is empty */
+static uint32_t list_head(struct history *h, uint32_t gram)
+{
+	/* the head is the posting of the newest line with the gram, which is dropped last */
+	if(h->grams[gram].count == 0)
+		return HIST_POSTINGS;
+	return h->grams[gram].head;
+}
+
+/* posting after p on its list, or HIST_POSTINGS at the end of the list */
+static uint32_t list_next(struct history *h, uint32_t p)
+{
+	uint32_t q = h->post[p];
+
+	/* a dropped posting is older than the live ones, a reused one is newer than p */
+	if(q == HIST_POSTINGS || age(h, q) >= h->pused || age(h, q) <= age(h, p))
+		return HIST_POSTINGS;
+	return q;
+}
+
+/* entry of the live posting p: the newest line whose first posting is not newer than p */
+static struct hist_entry *line_of(struct history *h, uint32_t p)
+{
+	uint64_t lo = h->first, hi = h->next - 1;
+
+	while(lo < hi)
+	{
+		uint64_t mid = lo + (hi - lo + 1) / 2;
+		if(age(h, h->ent[SLOT(mid)].post) >= age(h, p))
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return &h->ent[SLOT(lo)];
+}
+
+/* add a posting of the line e being added to the list of gram, unless the line is already on it */
+static void post_gram(struct history *h, struct hist_entry *e, uint32_t gram)
+{
+	uint32_t head = list_head(h, gram);
+
+	/* the postings of e are the newest nposts */
+	if(head != HIST_POSTINGS && age(h, head) < e->nposts)
+		return;
+
+	h->post[h->ppos] = head;
+	h->grams[gram].head = h->ppos;
+	h->grams[gram].count++;
+	h->ppos = (h->ppos + 1) % HIST_POSTINGS;
+	e->nposts++;
+	h->pused++;
+}
+
+/* find the index slot holding the live line s, or the empty slot where it would go */
+static uint32_t index_probe(struct history *h, const char *s, size_t len, uint32_t hash)
+{
+	uint32_t i = hash & (HIST_INDEX_SIZE - 1);
+	while(h->index[i] != 0)
+	{
+		struct hist_entry *e = &h->ent[h->index[i] - 1];
+		if(e->hash == hash && e->len == len && memcmp(h->arena + e->off, s, len) == 0)
+			break;
+		i = (i + 1) & (HIST_INDEX_SIZE - 1);
+	}
+	return i;
+}
+
+/* remove a live entry from the index, shifting back the entries that probed past it */
+static void index_remove(struct history *h, struct hist_entry *e)
+{
+	uint32_t i = index_probe(h, h->arena + e->off, e->len, e->hash);
+	uint32_t j = i;
+
+	if(h->index[i] == 0)
+		return;
+	h->index[i] = 0;
+	while(1)
+	{
+		j = (j + 1) & (HIST_INDEX_SIZE - 1);
+		if(h->index[j] == 0)
+			return;
+		uint32_t home = h->ent[h->index[j] - 1].hash & (HIST_INDEX_SIZE - 1);
+		/* move j into the hole unless its home lies cyclically in (i, j] */
+		if(((j - home) & (HIST_INDEX_SIZE - 1)) >= ((j - i) & (HIST_INDEX_SIZE - 1)))
+		{
+			h->index[i] = h->index[j];
+			h->index[j] = 0;
+			i = j;
+		}
+	}
+}
+
+/* drop the oldest entry */
+static void evict(struct history *h)
+{
+	struct hist_entry *e = &h->ent[SLOT(h->first)];
+	if(!e->dead)
+		index_remove(h, e);
+
+	/* the grams are found again from the text, which is still in the arena, each one counted once */
+	h->stamp++;
+	for(size_t n = 1; n <= 3; n++)
+		for(size_t j = 0; j + n <= e->len; j++)
+		{
+			struct hist_gram *g = &h->grams[gram_of(h->arena + e->off + j, n)];
+			if(g->mark != h->stamp)
+			{
+				g->mark = h->stamp;
+				g->count--;
+			}
+		}
+
+	/* the postings stay in the ring until they are reused, the lists end at them once pused no longer covers them */
+	h->pused -= e->nposts;
+	h->first++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	history_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void history_init(struct history *h);
+--					struct history *h: the history to empty
+--
+-- RETURNS: void
+--
+-- NOTES: Empties the history. Must be called before any other history function.
+--------------------------------------------------------------------------------------------------------------------*/
+void history_init(struct history *h)
+{
+	h->first = 0;
+	h->next = 0;
+	h->wpos = 0;
+	h->ppos = 0;
+	h->pused = 0;
+	h->stamp = 0;
+	memset(h->index, 0, sizeof(h->index));
+	memset(h->grams, 0, sizeof(h->grams));
+}
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	history_add
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void history_add(struct history *h, const char *line, size_t len);
+--					struct history *h:	the history to add to
+--					const char *line:	text of the line, does not need to be NULL terminated
+--					size_t len:			length of the line
+--
+-- RETURNS: void
+--
+-- NOTES: Copies the line into the ring as the most recent entry, dropping the oldest entries when there is no room.
+-- An older copy of the same line is marked dead so that recall and search never return the same line twice.
+-- Empty lines are ignored.
+--------------------------------------------------------------------------------------------------------------------*/
+void history_add(struct history *h, const char *line, size_t len)
+{
+	uint32_t hash, i, start;
+	struct hist_entry *e;
+
+	if(len == 0 || len > HIST_ARENA_SIZE || len > UINT16_MAX)
+		return;
+
+	/* an older copy of the line stays in the ring for ordering, but is no longer returned */
+	hash = hash_line(line, len);
+	i = index_probe(h, line, len, hash);
+	if(h->index[i] != 0)
+	{
+		h->ent[h->index[i] - 1].dead = 1;
+		index_remove(h, &h->ent[h->index[i] - 1]);
+	}
+
+	if(h->next - h->first == HIST_MAX_LINES)
+		evict(h);
+
+	/* a line has at most three grams per character */
+	while(h->first != h->next && h->pused + 3 * len > HIST_POSTINGS)
+		evict(h);
+
+	/* lines never wrap inside the arena, the entries left at the end are the oldest ones */
+	start = h->wpos;
+	if(start + len > HIST_ARENA_SIZE)
+	{
+		while(h->first != h->next && h->ent[SLOT(h->first)].off >= start)
+			evict(h);
+		start = 0;
+	}
+	while(h->first != h->next && h->ent[SLOT(h->first)].off >= start
+			&& h->ent[SLOT(h->first)].off < start + len)
+		evict(h);
+
+	memcpy(h->arena + start, line, len);
+	h->wpos = start + len;
+
+	e = &h->ent[SLOT(h->next)];
+	e->off = start;
+	e->len = (uint16_t)len;
+	e->dead = 0;
+	e->hash = hash;
+	e->post = h->ppos;
+	e->nposts = 0;
+	for(size_t n = 1; n <= 3; n++)
+		for(size_t j = 0; j + n <= len; j++)
+			post_gram(h, e, gram_of(line + j, n));
+
+	h->index[index_probe(h, line, len, hash)] = SLOT(h->next) + 1;
+	h->next++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	history_recall
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const char *history_recall(struct history *h, size_t back, size_t *len);
+--					struct history *h:	the history to read from
+--					size_t back:		how many lines to go back, 0 is the most recent line
+--					size_t *len:		set to the length of the line found
+--
+-- RETURNS: Pointer to the text of the line, not NULL terminated, or NULL if there is no such line. The pointer is
+-- only valid until the next call to history_add.
+--
+-- NOTES: Lines that were added again are only counted once, at their newest position.
+--------------------------------------------------------------------------------------------------------------------*/
+const char *history_recall(struct history *h, size_t back, size_t *len)
+{
+	for(uint64_t seq = h->next; seq != h->first; seq--)
+	{
+		struct hist_entry *e = &h->ent[SLOT(seq - 1)];
+		if(e->dead)
+			continue;
+		if(back-- == 0)
+		{
+			*len = e->len;
+			return h->arena + e->off;
+		}
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	history_search
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len);
+--					struct history *h:	the history to search
+--					const char *query:	text to look for inside the lines
+--					size_t qlen:		length of the query
+--					size_t *len:		set to the length of the line found
+--
+-- RETURNS: Pointer to the most recent line containing the query, or NULL if no line contains it. The pointer is only
+-- valid until the next call to history_add.
+--
+-- NOTES: Only the lines on the posting list of the rarest gram of the query are looked at, newest first, and each
+-- one is confirmed with memmem(). A query of one or two characters is a gram itself, so its list holds exactly the
+-- lines that contain it, apart from hash collisions. Walking the list of every gram at once would need to skip over
+-- the longer lists, which linked lists can not do, while confirming a candidate of the shortest list costs a
+-- single memmem() over at most a line.
+--------------------------------------------------------------------------------------------------------------------*/
+const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len)
+{
+	uint32_t gram, best = 0, n = qlen < 3 ? qlen : 3;
+
+	if(qlen == 0)
+		return history_recall(h, 0, len);
+
+	/* the gram of the query that the fewest lines have */
+	for(size_t j = 0; j + n <= qlen; j++)
+	{
+		gram = gram_of(query + j, n);
+		if(j == 0 || h->grams[gram].count < h->grams[best].count)
+			best = gram;
+	}
+
+	for(uint32_t p = list_head(h, best); p != HIST_POSTINGS; p = list_next(h, p))
+	{
+		struct hist_entry *e = line_of(h, p);
+		if(e->dead || e->len < qlen)
+			continue;
+		if(memmem(h->arena + e->off, e->len, query, qlen) != NULL)
+		{
+			*len = e->len;
+			return h->arena + e->off;
+		}
+	}
+	return NULL;
+}
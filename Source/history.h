@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	history.c - Keeps a bounded, indexed history of the lines submitted by the input process
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void history_init(struct history *h);
+--				void history_add(struct history *h, const char *line, size_t len);
+--				const char *history_recall(struct history *h, size_t back, size_t *len);
+--				const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Every line sent to the translate process is copied into a fixed byte arena that is used as a ring, so no
+-- memory is allocated per line. When the arena or the entry table is full the oldest lines are dropped.
+-- Two indexes sit on top of the ring: an open addressing hash table for exact matches (also used to drop duplicate
+-- lines), and an n-gram index for substring search. Every distinct gram of one, two and three characters of a line
+-- gets a posting in a second fixed ring, and the postings of a gram are linked newest first from its bucket. A
+-- posting is nothing but the position of the previous posting of its gram: the lines post in the order they are
+-- added and are dropped in the same order, so the live postings are always the last pused positions of the ring,
+-- and the line of a posting is found from its position. A link that leads out of them, or to a newer posting that
+-- reused the position, simply ends the list, nothing is unlinked. When the posting ring is full the oldest lines
+-- are dropped as well.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HIST_MAX_LINES	32768						/* lines kept in the ring, power of two */
+#define HIST_ARENA_SIZE	(HIST_MAX_LINES * 32)		/* bytes of line text kept in the ring */
+#define HIST_INDEX_SIZE	(HIST_MAX_LINES * 2)		/* exact match hash slots, power of two */
+#define HIST_POSTINGS	(HIST_MAX_LINES * 64)		/* n-gram postings kept in the ring, lines of text average about two
+													   distinct grams per character, 64 at the 32 of the arena */
+#define HIST_GRAMS		65536						/* n-gram buckets, single characters have one each */
+
+/* one submitted line, its text lives in the arena */
+struct hist_entry
+{
+	uint32_t off;		/* offset of the text in the arena */
+	uint16_t len;		/* length of the text */
+	uint16_t dead;		/* set when a newer copy of the same line was added */
+	uint32_t hash;		/* hash of the text, used by the exact match index */
+	uint32_t post;		/* position of the first posting of the line */
+	uint32_t nposts;	/* postings of the line, they follow each other in the ring */
+};
+
+/* posting list of one gram bucket */
+struct hist_gram
+{
+	uint32_t head;		/* position of the newest posting */
+	uint32_t count;		/* lines in the ring with this gram */
+	uint32_t mark;		/* stamp of the last line dropped with this gram, so it is counted once per line */
+};
+
+struct history
+{
+	uint64_t first;							/* sequence number of the oldest entry */
+	uint64_t next;							/* sequence number of the next entry */
+	uint32_t wpos;							/* arena offset where the next line is written */
+	uint32_t ppos;							/* position where the next posting is written */
+	uint32_t pused;							/* postings of the lines in the ring, the last ones before ppos */
+	uint32_t stamp;							/* lines dropped so far */
+	struct hist_entry ent[HIST_MAX_LINES];	/* entries, indexed by sequence number */
+	uint32_t index[HIST_INDEX_SIZE];		/* entry slot + 1 of every live line, 0 when empty */
+	struct hist_gram grams[HIST_GRAMS];		/* substring index, one posting list per gram */
+	uint32_t post[HIST_POSTINGS];			/* n-gram postings: position of the previous posting of the gram */
+	char arena[HIST_ARENA_SIZE];			/* line text */
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	history_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void history_init(struct history *h);
+--					struct history *h: the history to empty
+--
+-- RETURNS: void
+--
+-- NOTES: Empties the history. Must be called before any other history function.
+--------------------------------------------------------------------------------------------------------------------*/
+void history_init(struct history *h);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	history_add
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void history_add(struct history *h, const char *line, size_t len);
+--					struct history *h:	the history to add to
+--					const char *line:	text of the line, does not need to be NULL terminated
+--					size_t len:			length of the line
+--
+-- RETURNS: void
+--
+-- NOTES: Copies the line into the ring as the most recent entry, dropping the oldest entries when there is no room.
+-- An older copy of the same line is marked dead so that recall and search never return the same line twice.
+-- Empty lines are ignored.
+--------------------------------------------------------------------------------------------------------------------*/
+void history_add(struct history *h, const char *line, size_t len);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	history_recall
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const char *history_recall(struct history *h, size_t back, size_t *len);
+--					struct history *h:	the history to read from
+--					size_t back:		how many lines to go back, 0 is the most recent line
+--					size_t *len:		set to the length of the line found
+--
+-- RETURNS: Pointer to the text of the line, not NULL terminated, or NULL if there is no such line. The pointer is
+-- only valid until the next call to history_add.
+--
+-- NOTES: Lines that were added again are only counted once, at their newest position.
+--------------------------------------------------------------------------------------------------------------------*/
+const char *history_recall(struct history *h, size_t back, size_t *len);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	history_search
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len);
+--					struct history *h:	the history to search
+--					const char *query:	text to look for inside the lines
+--					size_t qlen:		length of the query
+--					size_t *len:		set to the length of the line found
+--
+-- RETURNS: Pointer to the most recent line containing the query, or NULL if no line contains it. The pointer is only
+-- valid until the next call to history_add.
+--
+-- NOTES: Only the lines on the posting list of the rarest gram of the query are looked at, newest first, and each
+-- one is confirmed with memmem(). A query of one or two characters is a gram itself, so its list holds exactly the
+-- lines that contain it, apart from hash collisions. Walking the list of every gram at once would need to skip over
+-- the longer lists, which linked lists can not do, while confirming a candidate of the shortest list costs a
+-- single memmem() over at most a line.
+--------------------------------------------------------------------------------------------------------------------*/
+const char *history_search(struct history *h, const char *query, size_t qlen, size_t *len);
+
+#endif
@@ -1,5 +1,6 @@
 #include "utilities.h"
 #include "processes.h"
+#include "supervisor.h"
 
 /*------------------------------------------------------------------------------------------------------------------
 -- SOURCE FILE:	Asn1.c - An application that reads keyboard input, then processes and displays
@@ -7,12 +8,15 @@
 -- 
 -- PROGRAM:		Asn1
 -- 
--- FUNCTIONS:	intt main(void)
+-- FUNCTIONS:	int main(int argc, char *argv[])
 --
 -- 
 -- DATE:		January 8, 2016
 -- 
--- REVISIONS:
+-- REVISIONS:	October 18, 2026 - command line options for the automation FIFO and socket
+--				October 18, 2026 - optional event tracing(-t)
+--				October 18, 2026 - the parent supervises the three processes and restarts the ones that die
+--				October 18, 2026 - multi-pattern substitution of translated lines(-p)
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -22,10 +26,17 @@
 -- different processes: input, output, and translate. The input process reads inputs recived from a terminal keyboard
 -- and echoed to the screen by the output process. each line is modified and handled by the translate process, which will
 -- also be echoed out by the output process. Each invidivual processes will communicate via pipes.
+-- Lines can also be injected by automation through a FIFO(-f) and a Unix socket(-s), at most -r lines per second
+-- from each of them. With -t every key and line is traced and written out as Chrome trace JSON at exit.
+-- The parent process is a supervisor: it keeps the session state in shared memory and creates again any of the
+-- three processes that dies, without ending the session.
+-- With -p the tokens listed in a pattern file are replaced in every translated line, see subst.c.
 --
 --------------------------------------------------------------------------------------------------------------------*/
-int main(void) 
+int main(int argc, char *argv[]) 
 {
+	parse_options(argc, argv);
+
 	/* Catch signals */
 	signal(SIGABRT, handle_signal);
 	signal(SIGTERM, handle_signal);
@@ -37,26 +48,21 @@ int main(void)
 	create_pipe(pipe_in_trans);
 	create_pipe(pipe_in_out);
 
-	/* Get input pid */
-	id_in = getpid();
+	/* Get supervisor pid */
+	id_sup = getpid();
+
+	/* shared trace rings, mapped before the processes are created */
+	if(opts.trace_path != NULL)
+		trace_open();
 
 	/* toogle off terminal proccesses */
 	toogle_termproc(OFF);
 
-	/* translate process */
-	if(create_process(&id_trans) == 0)	
-	{
-		handle_translate(pipe_in_trans, pipe_in_out);
-	}else
-	/* output process */
-	if(create_process(&id_out) == 0)
-	{
-		handle_output(pipe_in_out);
-	}else
-	/* parent(input) process */
-	{
-		handle_input(pipe_in_trans, pipe_in_out);
-	}
+	/* session state shared with the processes */
+	session_open();
+
+	/* translate, output and input processes, restarted when they die */
+	supervise(pipe_in_trans, pipe_in_out);
    	return 0;
 }
 
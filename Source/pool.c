@@ -0,0 +1,228 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	pool.c - Work stealing thread pool used by the batch translator
+--
+-- PROGRAM:		batch
+--
+-- FUNCTIONS:	void pool_start(struct pool *p, int workers);
+--				void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg);
+--				void pool_finish(struct pool *p);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Every worker owns a bounded deque of tasks. Submitted tasks are dealt out to the deques in turn, and a
+-- worker takes its own tasks from the front, oldest first. A worker whose deque is empty steals from the back of
+-- another worker's deque, so a worker stuck on one large file does not hold up the small files queued behind it.
+-- Each deque has its own lock, the pool lock is only taken to sleep and to wake up. pool_submit blocks while every
+-- deque is full, so the number of queued tasks never grows past workers * POOL_DEQUE_SIZE.
+--------------------------------------------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+/* argument of a worker thread */
+struct worker
+{
+	struct pool *p;
+	int id;
+};
+
+static struct worker worker_args[POOL_MAX_WORKERS];
+
+static int push(struct pool_deque *d, struct pool_task *t)
+{
+	int ok = 0;
+
+	pthread_mutex_lock(&d->lock);
+	if(d->tail - d->head < POOL_DEQUE_SIZE)
+	{
+		d->task[d->tail++ % POOL_DEQUE_SIZE] = *t;
+		ok = 1;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return ok;
+}
+
+/* the owner takes the oldest task, a thief the newest */
+static int take(struct pool_deque *d, struct pool_task *t, int steal)
+{
+	int ok = 0;
+
+	pthread_mutex_lock(&d->lock);
+	if(d->head != d->tail)
+	{
+		*t = steal ? d->task[--d->tail % POOL_DEQUE_SIZE] : d->task[d->head++ % POOL_DEQUE_SIZE];
+		ok = 1;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return ok;
+}
+
+static void *worker_main(void *arg)
+{
+	struct worker *w = arg;
+	struct pool *p = w->p;
+	struct pool_task t;
+
+	while(1)
+	{
+		int found = take(&p->deque[w->id], &t, 0);
+
+		for(int i = 1; !found && i < p->workers; i++)
+			found = take(&p->deque[(w->id + i) % p->workers], &t, 1);
+
+		pthread_mutex_lock(&p->lock);
+		if(found)
+		{
+			p->queued--;
+			pthread_cond_signal(&p->room);
+			pthread_mutex_unlock(&p->lock);
+			t.fn(t.arg);
+			continue;
+		}
+
+		/* nothing to take, sleep until a task is queued or the pool is closed */
+		while(p->queued == 0 && !p->closing)
+			pthread_cond_wait(&p->work, &p->lock);
+		if(p->queued == 0 && p->closing)
+		{
+			pthread_mutex_unlock(&p->lock);
+			return NULL;
+		}
+		pthread_mutex_unlock(&p->lock);
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_start
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_start(struct pool *p, int workers);
+--					struct pool *p:	the pool to start
+--					int workers:	number of worker threads, limited to POOL_MAX_WORKERS
+--
+-- RETURNS: void
+--
+-- NOTES: Starts the worker threads, exits the program if a thread can not be created.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_start(struct pool *p, int workers)
+{
+	if(workers < 1)
+		workers = 1;
+	if(workers > POOL_MAX_WORKERS)
+		workers = POOL_MAX_WORKERS;
+
+	p->workers = workers;
+	p->next = 0;
+	p->closing = 0;
+	p->queued = 0;
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->work, NULL);
+	pthread_cond_init(&p->room, NULL);
+
+	for(int i = 0; i < workers; i++)
+	{
+		pthread_mutex_init(&p->deque[i].lock, NULL);
+		p->deque[i].head = 0;
+		p->deque[i].tail = 0;
+	}
+
+	for(int i = 0; i < workers; i++)
+	{
+		int err;
+
+		worker_args[i].p = p;
+		worker_args[i].id = i;
+		if((err = pthread_create(&p->thread[i], NULL, worker_main, &worker_args[i])) != 0)
+		{
+			fprintf(stderr, "pthread_create: %s\n", strerror(err));
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_submit
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg);
+--					struct pool *p:	the pool
+--					fn:				function a worker runs
+--					void *arg:		passed to fn
+--
+-- RETURNS: void
+--
+-- NOTES: Queues fn(arg), waiting for room if every deque is full.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg)
+{
+	struct pool_task t = { fn, arg };
+
+	pthread_mutex_lock(&p->lock);
+	while(1)
+	{
+		for(int i = 0; i < p->workers; i++)
+		{
+			int d = (p->next + i) % p->workers;
+			if(push(&p->deque[d], &t))
+			{
+				p->next = (d + 1) % p->workers;
+				p->queued++;
+				pthread_cond_signal(&p->work);
+				pthread_mutex_unlock(&p->lock);
+				return;
+			}
+		}
+		pthread_cond_wait(&p->room, &p->lock);
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_finish
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_finish(struct pool *p);
+--					struct pool *p: the pool
+--
+-- RETURNS: void
+--
+-- NOTES: Waits until every queued task has run, then stops the worker threads.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_finish(struct pool *p)
+{
+	pthread_mutex_lock(&p->lock);
+	p->closing = 1;
+	pthread_cond_broadcast(&p->work);
+	pthread_mutex_unlock(&p->lock);
+
+	for(int i = 0; i < p->workers; i++)
+		pthread_join(p->thread[i], NULL);
+}
@@ -0,0 +1,124 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	pool.c - Work stealing thread pool used by the batch translator
+--
+-- PROGRAM:		batch
+--
+-- FUNCTIONS:	void pool_start(struct pool *p, int workers);
+--				void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg);
+--				void pool_finish(struct pool *p);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Every worker owns a bounded deque of tasks. Submitted tasks are dealt out to the deques in turn, and a
+-- worker takes its own tasks from the front, oldest first. A worker whose deque is empty steals from the back of
+-- another worker's deque, so a worker stuck on one large file does not hold up the small files queued behind it.
+-- Each deque has its own lock, the pool lock is only taken to sleep and to wake up. pool_submit blocks while every
+-- deque is full, so the number of queued tasks never grows past workers * POOL_DEQUE_SIZE.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _POOL_H
+#define _POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+#define POOL_MAX_WORKERS	64
+#define POOL_DEQUE_SIZE		16		/* tasks queued per worker */
+
+struct pool_task
+{
+	void (*fn)(void *arg);
+	void *arg;
+};
+
+struct pool_deque
+{
+	pthread_mutex_t lock;
+	size_t head;							/* next task the owner takes */
+	size_t tail;							/* next free slot */
+	struct pool_task task[POOL_DEQUE_SIZE];
+};
+
+struct pool
+{
+	int workers;
+	int next;								/* deque the next task is given to */
+	int closing;							/* set by pool_finish, workers exit once nothing is queued */
+	size_t queued;							/* tasks in all deques */
+	pthread_mutex_t lock;					/* protects closing and queued */
+	pthread_cond_t work;					/* signalled when a task is queued */
+	pthread_cond_t room;					/* signalled when a task is taken */
+	pthread_t thread[POOL_MAX_WORKERS];
+	struct pool_deque deque[POOL_MAX_WORKERS];
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_start
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_start(struct pool *p, int workers);
+--					struct pool *p:	the pool to start
+--					int workers:	number of worker threads, limited to POOL_MAX_WORKERS
+--
+-- RETURNS: void
+--
+-- NOTES: Starts the worker threads, exits the program if a thread can not be created.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_start(struct pool *p, int workers);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_submit
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg);
+--					struct pool *p:	the pool
+--					fn:				function a worker runs
+--					void *arg:		passed to fn
+--
+-- RETURNS: void
+--
+-- NOTES: Queues fn(arg), waiting for room if every deque is full.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_submit(struct pool *p, void (*fn)(void *arg), void *arg);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	pool_finish
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void pool_finish(struct pool *p);
+--					struct pool *p: the pool
+--
+-- RETURNS: void
+--
+-- NOTES: Waits until every queued task has run, then stops the worker threads.
+--------------------------------------------------------------------------------------------------------------------*/
+void pool_finish(struct pool *p);
+
+#endif
@@ -6,7 +6,6 @@
 -- FUNCTIONS:	void handle_input(int pipe_in_trans[2], int pipe_in_out[2]);
 --				void handle_output(int pipe_in_out[2]);
 -- 				void handle_translate(int pipe_in_trans[2], int pipe_in_out[2]);
---				void translate(char buf[MSG_SIZE], char to[MSG_SIZE]);
 --				void init_empty_buf(char buf[MSG_SIZE]);
 --
 -- DATE:		January 7, 2015
@@ -28,6 +27,7 @@
 --	Inputs such as ^K and T will send abort and terminate signals to all three processes.
 --------------------------------------------------------------------------------------------------------------------*/
 #include "processes.h"
+#include "supervisor.h"
 
 /*------------------------------------------------------------------------------------------------------------------ 
 -- FUNCTION:	handle_input
@@ -46,21 +46,114 @@
 -- 
 -- RETURNS: void
 -- 
--- NOTES: The parent process. Reads keyboard inputs and writes each respective characters to the output process for it
+-- NOTES: Child process of the supervisor. Reads keyboard inputs and writes each respective characters to the output process for it
 -- to be echoed onto the screen until the carriage return(E) is recived, which then writes the stream of data recorded
 -- to the translate process. 
 -- When the abnormal terminate key(^k) is caught, it will send the abort signal to all processes running within the 
 -- program.
 --------------------------------------------------------------------------------------------------------------------*/
-pid_t id_trans, id_out, id_in;
-int isterm = 0;
+pid_t id_trans, id_out, id_in, id_sup;
+
+struct options opts = { NULL, NULL, SRC_RATE, NULL, NULL };
+
+/* add a whole line to the history and write it to the translator pipe as one message */
+static void submit_line(struct input *in, const char *line, size_t len)
+{
+	struct line_msg msg;
+	uint32_t ends = 0;
+	uint64_t start = TRACE_NOW();
+
+	init_empty_buf(msg.text);
+	memcpy(msg.text, line, len);
+	history_add(&session->hist, msg.text, len);
+
+	/* an id for every line the message ends: one per 'E' or 'T', and the end of the message unless it was one */
+	for(size_t i = 0; i < len; i++)
+		if(line[i] == CARRIAGE_RETURN || line[i] == NORM_TERM)
+			ends++;
+	if(len == 0 || (line[len - 1] != CARRIAGE_RETURN && line[len - 1] != NORM_TERM))
+		ends++;
+	msg.id = in->lines;
+	in->lines += ends;
+
+	if (write(in->trans_fd, &msg, sizeof(msg)) < 0)
+		error("input write()");
+
+	for(uint32_t i = 0; i < ends; i++)
+		TRACE(TRACE_INPUT, EV_LINE, msg.id + i, start);
+}
+
+/* a whole line from an automation source */
+static void input_line(const char *line, size_t len, void *arg)
+{
+	struct input *in = arg;
+
+	/* the line goes on top of the history, so ^P starts from it again */
+	in->recall = 0;
+	submit_line(in, line, len);
+}
+
+/* a single key from the keyboard */
+static void input_key(char c, void *arg)
+{
+	struct input *in = arg;
+	const char *line;
+	size_t len;
+	uint32_t id;
+	uint64_t start = TRACE_NOW();
+
+	/* the bytes that frame translated lines on the output pipe can not be typed */
+	if(c == TRANS_MARK || c == '\0')
+		return;
+
+	/* write to ouput pipe, every key is echoed so the output process numbers them the same way */
+	id = in->keys++;
+	if(write(in->out_fd, &c, 1) < 0)
+		error("input write()");
+
+	if(c == ABNORM_TERM)			/* '^K' detected */
+	{
+		kill(getpid(), SIGABRT);
+	}else
+	if(c == CARRIAGE_RETURN)		/* 'E' detected */
+	{
+		submit_line(in, in->msg, in->index);
+		init_empty_buf(in->msg);
+		in->index = 0;
+	}else
+	if(c == HIST_RECALL || c == HIST_SEARCH)	/* '^P' or '^R' detected */
+	{
+		/* each recalled line is added again on top, so the line recall lines back is the next older one */
+		if(c == HIST_RECALL)
+			line = history_recall(&session->hist, in->recall, &len);
+		else
+			line = history_search(&session->hist, in->msg, in->index, &len);
+		in->recall = c == HIST_RECALL && line != NULL ? in->recall + 1 : 0;
+
+		/* the typed characters are discarded either way */
+		init_empty_buf(in->msg);
+		in->index = 0;
+		if(line != NULL)
+			submit_line(in, line, len);
+	}else
+	if(in->index < MSG_SIZE - 1)	/* keep room for the NULL terminator */
+		in->msg[in->index++] = c;
+
+	/* any other key ends a run of ^P */
+	if(c != HIST_RECALL)
+		in->recall = 0;
+
+	TRACE(TRACE_INPUT, EV_KEY, id, start);
+}
 
 /*------------------------------------------------------------------------------------------------------------------ 
 -- FUNCTION:	handle_input
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - submitted lines are kept in a history, ^P and ^R recall them
+--				October 18, 2026 - also reads automation lines from a FIFO and a Unix socket
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -72,43 +165,38 @@ int isterm = 0;
 -- 
 -- RETURNS: void
 -- 
--- NOTES: The parent process. Reads keyboard inputs and writes each respective characters to the output process for it
+-- NOTES: Child process of the supervisor. Reads keyboard inputs and writes each respective characters to the output process for it
 -- to be echoed onto the screen until the carriage return(E) is recived, which then writes the stream of data recorded
 -- to the translate process. 
 -- When the abnormal terminate key(^k) is caught, it will send the abort signal to all processes running within the 
 -- program.
+-- Every line sent to the translate process is added to the line history. The recall key(^P) sends the previous line
+-- to the translate process again, and each ^P pressed right after it goes one line further back. The search key(^R)
+-- sends the most recent line containing the characters typed so far. A recalled line is written to the translate
+-- process as a single message.
+-- Whole lines injected through the FIFO(-f) and the Unix socket(-s) are merged with the keyboard by sources_poll and
+-- written to the translate process in the order they arrive.
+-- The line being typed, the history and the sources live in the shared session, so a restarted input process
+-- carries on with them, with the automation lines it had not sent yet and the clients that were connected.
+-- Each key is traced with its id, and each line with the ids of the lines it ends, which travel with the message.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_input(int pipe_in_trans[2], int pipe_in_out[2])
 {
-	char c, msg[MSG_SIZE];
-	size_t index = 0;
-	init_empty_buf(msg);
+	struct input *in = &session->in;
+
+	/* the line being typed is kept by the supervisor, a restarted input process carries on with it */
+	in->trans_fd = pipe_in_trans[1];
+	in->out_fd = pipe_in_out[1];
 
 	/* close translator and output read descriptor */
 	close(pipe_in_trans[0]);
 	close(pipe_in_out[0]);
 
-	while((c = getchar()))				/* Check for keyboard inputs */
-	{
-		/* write to ouput pipe */
-		if(write(pipe_in_out[1], &c, 1) < 0)
-			error("input write()");
+	/* keyboard, plus the automation fifo and socket when given, opened by the supervisor */
+	sources_attach(&session->srcs);
 
-		if(c == ABNORM_TERM)			/* '^K' detected */
-		{
-			kill(getpid(), SIGABRT);
-		}else
-		if(c == CARRIAGE_RETURN)		/* 'E' detected */
-		{
-			/* write to translator pipe */
-			if (write(pipe_in_trans[1], msg, MSG_SIZE) < 0)
-				error("input write()");
-
-			init_empty_buf(msg);
-			index = 0;
-		}else
-			msg[index++] = c;
-	}
+	while(1)
+		sources_poll(&session->srcs, input_key, input_line, in);
 }
 
 /*------------------------------------------------------------------------------------------------------------------ 
@@ -116,7 +204,10 @@ void handle_input(int pipe_in_trans[2], int pipe_in_out[2])
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - translates with the translator library instead of translate()
+--				October 18, 2026 - sends each line as a single frame
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
+--				October 18, 2026 - rewrites the tokens of the pattern file(-p) in every line
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -128,48 +219,92 @@ void handle_input(int pipe_in_trans[2], int pipe_in_out[2])
 -- 
 -- RETURNS: void
 -- 
--- NOTES: Child process of input. Reads data sent from the input process and translate characters based on given
+-- NOTES: Child process of the supervisor. Reads data sent from the input process and translate characters based on given
 -- constraints. For example, 'a' will be converted to 'z', 'X' will be read as backspace, 'K' will discard all 
 -- preceeding characters. After the translation, the data is then sent to the output process via its pipe.
+-- The translator context lives in the shared session, so it lasts the whole session and a restarted translate
+-- process carries on with it. The end of every message also ends its line. A message from an automation source
+-- can hold several lines separated by 'E', each one is sent on its own, in a single write framed by TRANS_MARK and
+-- a NULL so the output process can tell it from the echoed keys. The line id of the message goes into the frame
+-- too, each line of a message taking the next one, so a line can be followed through the trace.
+-- With -p each translated line then goes through the substitution automaton of the pattern file, which a thread of
+-- this process compiles again whenever the file changes. The replacements can make a line up to FRAME_MAX long, a
+-- longer one is cut and ends with a note of how many characters were dropped.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_translate(int pipe_in_trans[2], int pipe_in_out[2])
 {
+	struct translator *tr = &session->tr;
+	static struct subst_watch subst;
+
 	/* close output read descriptor */
 	close(pipe_in_out[0]);
 	/* close translate write descriptor */
 	close(pipe_in_trans[1]);
 
+	subst_watch_start(&subst, opts.subst_path);
+
 	while(1)
 	{
+		size_t len, off = 0;
+		uint32_t id;
 
 		/* buffer for incoming and outgoing messages from input to output pipe */
-		char read_msg[MSG_SIZE], write_msg[MSG_SIZE];
+		struct line_msg read_msg;
+		char write_msg[FRAME_HEAD + MSG_SIZE], subst_msg[FRAME_MAX];
 
-		init_empty_buf(read_msg);
-		init_empty_buf(write_msg);
+		init_empty_buf(read_msg.text);
 
 		/* read from translate pipe */
-		if(read(pipe_in_trans[0], read_msg, MSG_SIZE) < 0)
+		if(read(pipe_in_trans[0], &read_msg, sizeof(read_msg)) < 0)
 			error("translate read()");
+		len = strnlen(read_msg.text, MSG_SIZE);
+		id = read_msg.id;
 
-		/* replace 'a' with 'z', handles backspace, kill line, and normal terminate*/
-		translate(read_msg, write_msg);
+		/* a message may hold several lines, and its end always ends the last one */
+		do
+		{
+			uint64_t start = TRACE_NOW();
+			const struct subst *sb;
+			char *frame = write_msg;
+			size_t used, n;
+			int ev;
+
+			/* replace 'a' with 'z', handles backspace, kill line, and normal terminate*/
+			ev = translator_feed(tr, read_msg.text + off, len - off, &used, write_msg + FRAME_HEAD, MSG_SIZE, &n);
+			off += used;
+			if(ev == TR_NONE)
+				ev = translator_flush(tr, write_msg + FRAME_HEAD, MSG_SIZE, &n);
+
+			if(ev == TR_ABORT)
+				kill(getpid(), SIGABRT);
 
-		/* write a new line to output pipe */
-		if (write(pipe_in_out[1], "\r\n", 2) < 0)
-			error("input write()");
+			/* rewrite the tokens of the pattern file, the replacements can make the line longer than a frame */
+			if((sb = subst_current(&subst)) != NULL)
+			{
+				size_t full = subst_apply(sb, write_msg + FRAME_HEAD, n, subst_msg + FRAME_HEAD, FRAME_MAX - FRAME_HEAD);
 
-		/* write translated message to output pipe */
-		if (write(pipe_in_out[1], write_msg, MSG_SIZE) < 0)
-			error("translate write()");
+				n = full;
+				if(full >= FRAME_MAX - FRAME_HEAD)
+				{
+					/* cut it, and say so on the line itself */
+					n = FRAME_MAX - FRAME_HEAD - 1 - FRAME_NOTE;
+					n += snprintf(subst_msg + FRAME_HEAD + n, FRAME_NOTE + 1, "... (%zu characters cut)", full - n);
+				}
+				frame = subst_msg;
+			}
 
-		/* write a new line to output pipe*/
-		if (write(pipe_in_out[1], "\r\n", 2) < 0)
-			error("input write()");
+			/* write translated message to output pipe as one frame: TRANS_MARK, the line id, the line and its NULL */
+			frame[0] = TRANS_MARK;
+			memcpy(frame + 1, &id, sizeof(id));
+			if (write(pipe_in_out[1], frame, FRAME_HEAD + n + 1) < 0)
+				error("translate write()");
 
-		/* check if NORM_TERM is recieved */
-		if(isterm)
-			kill(getpid(), SIGTERM);
+			TRACE(TRACE_TRANSLATE, EV_TRANSLATE, id++, start);
+
+			/* check if NORM_TERM is recieved */
+			if(ev == TR_TERMINATE)
+				kill(getpid(), SIGTERM);
+		}while(off < len);
 	}
 }
 
@@ -178,7 +313,8 @@ void handle_translate(int pipe_in_trans[2], int pipe_in_out[2])
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - draws through the renderer instead of copying the pipe to the screen
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -189,79 +325,45 @@ void handle_translate(int pipe_in_trans[2], int pipe_in_out[2])
 -- 
 -- RETURNS: void
 -- 
--- NOTES: Child process of input. Reads data from a pipe that is used by the input and translate process and echos
+-- NOTES: Child process of the supervisor. Reads data from a pipe that is used by the input and translate process and echos
 -- the data onto the screen.
+-- Everything waiting in the pipe is read at once and handed to the renderer, which keeps a model of the line being
+-- typed and writes only the bytes needed to bring the screen up to date, in a single write.
+-- The screen model lives in the shared session, so a restarted output process carries on with it.
+-- Every write to the screen is traced together with the ids of the keys echoed and the lines drawn by it. Keys are
+-- numbered in the order they are echoed, the same way the input process numbers them.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_output(int pipe_in_out[2])
 {
+	struct render *scr = &session->scr;
+
 	/* close output write descriptor */
 	close(pipe_in_out[1]);
 	while(1)
 	{
-		char msg[MSG_SIZE];
-		init_empty_buf(msg);
+		char msg[RENDER_BUF];
+		ssize_t n;
+		uint64_t start;
 
-		/* read from output pipe */
-		if(read(pipe_in_out[0], msg, MSG_SIZE) == 0)
+		/* read from output pipe, everything already waiting is drawn together */
+		if((n = read(pipe_in_out[0], msg, sizeof(msg))) <= 0)
+		{
 				error("output read()");
+				continue;
+		}
+		start = TRACE_NOW();
 
-		/* write to standard output */
-		if (write(STDOUT_FILENO, msg, MSG_SIZE) < 0)
-				error("output write()");
-	}
-}
+		/* update the screen model and write the difference to standard output */
+		render_feed(scr, msg, n);
+		render_flush(scr);
 
-/*------------------------------------------------------------------------------------------------------------------ 
--- FUNCTION:	translate
--- 
--- DATE:		January 7, 2015
--- 
--- REVISIONS:	
--- 
--- DESIGNER:	Ruoqi Jia
--- 
--- PROGRAMMER:	Ruoqi Jia
--- 
--- INTERFACE:	void translate(char from[MSG_SIZE], char to[MSG_SIZE]);
---					from[MSG_SIZE]: buffer data that is recieved from the input process
---					to[MSG_SIZE]: buffer data that will be write to the ouput process after modifications
--- 
--- RETURNS: void
--- 
--- NOTES: Takes in an populated buffer and attempts to translate its content into an empty buffer.
--- Character 'a' will be treated as 'z', 'X' will delete the previous character, 'K' will delete all preceeding 
--- characters.
--- isterm will be set to true when the normal terminate(T) key is detected
---------------------------------------------------------------------------------------------------------------------*/
-void translate(char from[MSG_SIZE], char to[MSG_SIZE])
-{
-	for(int i = 0, j = 0; from[i] != '\0'; i++, j++)
-	{
-		switch (from[i])
-		{
-			case CHAR_FROM: 	/* Replace a with z */
-				to[j] = CHAR_TO;
-				break;
-			case BACKSPACE:		/* "Delete" previous character */
-				/* make sure X is not the first character */
-				if(i != 0)
-				{
-					to[j-1] = '\0';
-					j = j - 2;
-				}
-				break;
-			case LINE_KILL:		/* "Delete" all previous characters*/
-				j = 0;
-				init_empty_buf(to);
-				break;
-			case NORM_TERM:		/* 'T' detected */
-				isterm = 1;
-				return;
-				break;
-			default:			/* Copy char to char */
-				to[j] = from[i];
-				break;
-		}
+		TRACE(TRACE_OUTPUT, EV_WRITE, session->chunks++, start);
+
+		/* the keys and lines drawn by this write, so they can be followed from the processes before */
+		for(size_t i = 0; i < scr->keys; i++)
+			TRACE(TRACE_OUTPUT, EV_ECHO, session->echoed++, start);
+		for(size_t i = 0; i < scr->ndrawn; i++)
+			TRACE(TRACE_OUTPUT, EV_DRAW, scr->drawn[i], start);
 	}
 }
 
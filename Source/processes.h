@@ -6,7 +6,6 @@
 -- FUNCTIONS:	void handle_input(int pipe_in_trans[2], int pipe_in_out[2]);
 --				void handle_output(int pipe_in_out[2]);
 -- 				void handle_translate(int pipe_in_trans[2], int pipe_in_out[2]);
---				void translate(char buf[MSG_SIZE], char to[MSG_SIZE]);
 --				void init_empty_buf(char buf[MSG_SIZE]);
 --
 -- DATE:		January 7, 2015
@@ -35,33 +34,68 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <signal.h>
 
 #include "utilities.h"
+#include "translator.h"
+#include "history.h"
+#include "sources.h"
+#include "trace.h"
+#include "render.h"
+#include "subst.h"
 
 #define MSG_SIZE		128		/* buffer size to write to pipe*/
 
-#define CHAR_FROM		0x61	/* character 'a' */
-#define CHAR_TO			0x7A	/* character 'z' */	
-#define CARRIAGE_RETURN	0x45	/* character 'E' */
-#define BACKSPACE		0x58	/* character 'X' */
-#define NORM_TERM		0x54	/* character 'T' */
-#define LINE_KILL		0x4B	/* character 'K' */
-#define ABNORM_TERM		0x0B	/* character '^K' */
+/* the translation keys are defined in translator.h */
+#define HIST_RECALL		0x10	/* character '^P' */
+#define HIST_SEARCH		0x12	/* character '^R' */
+#define TRANS_MARK		0x02	/* character '^B', starts a translated line on the output pipe */
+#define FRAME_HEAD		(1 + sizeof(uint32_t))	/* TRANS_MARK and the line id in front of a translated line */
+#define FRAME_MAX		PIPE_BUF	/* longest frame, only writes up to PIPE_BUF are kept whole on the pipe */
+#define FRAME_NOTE		48		/* room kept for the note of a line cut to fit in a frame */
 
-/* process IDs */
-extern pid_t id_trans, id_out, id_in;
+/* process IDs, id_sup is the supervisor */
+extern pid_t id_trans, id_out, id_in, id_sup;
 
-/* set to true when NORM_TERM is recieved in the translate process*/
-extern int isterm;
+/* state of the input process, shared by every input source */
+struct input
+{
+	int trans_fd;			/* write end of the translate pipe */
+	int out_fd;				/* write end of the output pipe */
+	char msg[MSG_SIZE];		/* line being typed on the keyboard */
+	size_t index;			/* characters in msg */
+	size_t recall;			/* lines ^P went back in a row, the next ^P goes one further */
+	uint32_t keys, lines;	/* trace ids given to keys and lines so far */
+};
+
+/* message from the input process to the translate process */
+struct line_msg
+{
+	uint32_t id;			/* trace id of the first line the message ends, each line after it takes the next id */
+	char text[MSG_SIZE];	/* the keys, NULL padded */
+};
+
+/* command line options */
+struct options
+{
+	const char *fifo_path;	/* -f: FIFO that automation lines are read from */
+	const char *sock_path;	/* -s: Unix socket that automation clients connect to */
+	int rate;				/* -r: lines per second allowed from each automation source, 0 for no limit */
+	const char *trace_path;	/* -t: file the trace is written to at exit, tracing is off when NULL */
+	const char *subst_path;	/* -p: pattern file of the substitutions, nothing is substituted when NULL */
+};
+extern struct options opts;
 
 /*------------------------------------------------------------------------------------------------------------------ 
 -- FUNCTION:	handle_input
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - submitted lines are kept in a history, ^P and ^R recall them
+--				October 18, 2026 - also reads automation lines from a FIFO and a Unix socket
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -73,11 +107,20 @@ extern int isterm;
 -- 
 -- RETURNS: void
 -- 
--- NOTES: The parent process. Reads keyboard inputs and writes each respective characters to the output process for it
+-- NOTES: Child process of the supervisor. Reads keyboard inputs and writes each respective characters to the output process for it
 -- to be echoed onto the screen until the carriage return(E) is recived, which then writes the stream of data recorded
 -- to the translate process. 
 -- When the abnormal terminate key(^k) is caught, it will send the abort signal to all processes running within the 
 -- program.
+-- Every line sent to the translate process is added to the line history. The recall key(^P) sends the previous line
+-- to the translate process again, and each ^P pressed right after it goes one line further back. The search key(^R)
+-- sends the most recent line containing the characters typed so far. A recalled line is written to the translate
+-- process as a single message.
+-- Whole lines injected through the FIFO(-f) and the Unix socket(-s) are merged with the keyboard by sources_poll and
+-- written to the translate process in the order they arrive.
+-- The line being typed, the history and the sources live in the shared session, so a restarted input process
+-- carries on with them, with the automation lines it had not sent yet and the clients that were connected.
+-- Each key is traced with its id, and each line with the ids of the lines it ends, which travel with the message.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_input(int pipe_in_trans[2], int pipe_in_out[2]);
 
@@ -86,7 +129,10 @@ void handle_input(int pipe_in_trans[2], int pipe_in_out[2]);
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - translates with the translator library instead of translate()
+--				October 18, 2026 - sends each line as a single frame
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
+--				October 18, 2026 - rewrites the tokens of the pattern file(-p) in every line
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -98,9 +144,17 @@ void handle_input(int pipe_in_trans[2], int pipe_in_out[2]);
 -- 
 -- RETURNS: void
 -- 
--- NOTES: Child process of input. Reads data sent from the input process and translate characters based on given
+-- NOTES: Child process of the supervisor. Reads data sent from the input process and translate characters based on given
 -- constraints. For example, 'a' will be converted to 'z', 'X' will be read as backspace, 'K' will discard all 
 -- preceeding characters. After the translation, the data is then sent to the output process via its pipe.
+-- The translator context lives in the shared session, so it lasts the whole session and a restarted translate
+-- process carries on with it. The end of every message also ends its line. A message from an automation source
+-- can hold several lines separated by 'E', each one is sent on its own, in a single write framed by TRANS_MARK and
+-- a NULL so the output process can tell it from the echoed keys. The line id of the message goes into the frame
+-- too, each line of a message taking the next one, so a line can be followed through the trace.
+-- With -p each translated line then goes through the substitution automaton of the pattern file, which a thread of
+-- this process compiles again whenever the file changes. The replacements can make a line up to FRAME_MAX long, a
+-- longer one is cut and ends with a note of how many characters were dropped.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_translate(int pipe_in_trans[2], int pipe_in_out[2]);
 
@@ -110,7 +164,8 @@ void handle_translate(int pipe_in_trans[2], int pipe_in_out[2]);
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - draws through the renderer instead of copying the pipe to the screen
+--				October 18, 2026 - runs under the supervisor, its state is kept in the shared session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -121,36 +176,17 @@ void handle_translate(int pipe_in_trans[2], int pipe_in_out[2]);
 -- 
 -- RETURNS: void
 -- 
--- NOTES: Child process of input. Reads data from a pipe that is used by the input and translate process and echos
+-- NOTES: Child process of the supervisor. Reads data from a pipe that is used by the input and translate process and echos
 -- the data onto the screen.
+-- Everything waiting in the pipe is read at once and handed to the renderer, which keeps a model of the line being
+-- typed and writes only the bytes needed to bring the screen up to date, in a single write.
+-- The screen model lives in the shared session, so a restarted output process carries on with it.
+-- Every write to the screen is traced together with the ids of the keys echoed and the lines drawn by it. Keys are
+-- numbered in the order they are echoed, the same way the input process numbers them.
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_output(int pipe_in_out[2]);
 
 
-/*------------------------------------------------------------------------------------------------------------------ 
--- FUNCTION:	translate
--- 
--- DATE:		January 7, 2015
--- 
--- REVISIONS:	
--- 
--- DESIGNER:	Ruoqi Jia
--- 
--- PROGRAMMER:	Ruoqi Jia
--- 
--- INTERFACE:	void translate(char from[MSG_SIZE], char to[MSG_SIZE]);
---					from[MSG_SIZE]: buffer data that is recieved from the input process
---					to[MSG_SIZE]: buffer data that will be write to the ouput process after modifications
--- 
--- RETURNS: void
--- 
--- NOTES: Takes in an populated buffer and attempts to translate its content into an empty buffer.
--- Character 'a' will be treated as 'z', 'X' will delete the previous character, 'K' will delete all preceeding 
--- characters.
--- isterm will be set to true when the normal terminate(T) key is detected
---------------------------------------------------------------------------------------------------------------------*/
-void translate(char from[MSG_SIZE], char to[MSG_SIZE]);
-
 /*------------------------------------------------------------------------------------------------------------------ 
 -- FUNCTION:	init_empty_buf
 -- 
@@ -0,0 +1,293 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	render.c - Draws the output process's screen with as few bytes as possible
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void render_init(struct render *r, int fd);
+--				void render_feed(struct render *r, const char *data, size_t len);
+--				void render_flush(struct render *r);
+--				void render_resume(struct render *r);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The output pipe carries the keys echoed by the input process and the lines framed by the translate
+-- process(TRANS_MARK, the line id, the line, then a NULL). Instead of copying them to the terminal, the renderer keeps two
+-- copies of the line being typed: the line as it should look after the edit keys('X', 'K') are applied, and the
+-- line as it is on the screen now. Everything read from the pipe in one go is applied to the first copy, then the
+-- two are compared and the cheapest escape sequence is picked to bring the screen up to date: backspaces, a
+-- cursor move or a carriage return and rewrite to reach the first changed column, then erase-to-EOL or blanks for
+-- what is left over. All of it goes to the terminal in a single write.
+-- The cursor column arithmetic assumes the line being typed does not wrap on the terminal. A translated line may, it
+-- is drawn once and followed by a new row.
+--------------------------------------------------------------------------------------------------------------------*/
+#include "processes.h"
+#include "render.h"
+
+#define ERASE_EOL	"\033[K"
+
+/* write out the pending bytes */
+static void drain(struct render *r)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while(off < r->out_len)
+	{
+		if((n = write(r->fd, r->out + off, r->out_len - off)) < 0)
+		{
+			error("output write()");
+			break;
+		}
+		off += n;
+	}
+	r->out_len = 0;
+}
+
+static void put(struct render *r, const char *s, size_t len)
+{
+	if(r->out_len + len > RENDER_BUF)
+		drain(r);
+	memcpy(r->out + r->out_len, s, len);
+	r->out_len += len;
+}
+
+static void put_repeat(struct render *r, char c, size_t count)
+{
+	while(count-- > 0)
+		put(r, &c, 1);
+}
+
+/* blank the count columns after the cursor, leaving the cursor where it is */
+static void erase(struct render *r, size_t count)
+{
+	if(count == 0)
+		return;
+	if(2 * count < sizeof(ERASE_EOL) - 1)
+	{
+		put_repeat(r, ' ', count);
+		put_repeat(r, '\b', count);
+	}else
+		put(r, ERASE_EOL, sizeof(ERASE_EOL) - 1);
+}
+
+/* bring shown up to date with line using the fewest bytes */
+static void sync_line(struct render *r)
+{
+	size_t p = 0, back;
+	char move[16];
+	int move_len;
+
+	while(p < r->len && p < r->shown_len && r->line[p] == r->shown[p])
+		p++;
+	if(p == r->len && p == r->shown_len)
+		return;
+
+	/* get the cursor back to column p: backspaces, a cursor left, or a carriage return and a rewrite */
+	back = r->shown_len - p;
+	move_len = snprintf(move, sizeof(move), "\033[%zuD", back);
+	if(back > 0)
+	{
+		if(back <= (size_t)move_len && back <= p + 1)
+			put_repeat(r, '\b', back);
+		else if((size_t)move_len <= p + 1)
+			put(r, move, move_len);
+		else
+		{
+			put(r, "\r", 1);
+			put(r, r->line, p);
+		}
+	}
+
+	put(r, r->line + p, r->len - p);
+	if(r->shown_len > r->len)
+		erase(r, r->shown_len - r->len);
+
+	memcpy(r->shown, r->line, r->len);
+	r->shown_len = r->len;
+}
+
+/* draw a translated line on the current row and start a new row for the line being typed */
+static void draw_frame(struct render *r)
+{
+	if(r->shown_len > 0)
+		put(r, "\r", 1);
+	put(r, r->frame, r->frame_len);
+	if(r->shown_len > r->frame_len)
+		erase(r, r->shown_len - r->frame_len);
+	put(r, "\r\n", 2);
+
+	/* the line being typed is drawn again on the new row by the next sync */
+	r->shown_len = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_init(struct render *r, int fd);
+--					struct render *r:	the renderer to set up
+--					int fd:				terminal to draw on
+--
+-- RETURNS: void
+--
+-- NOTES: Starts with an empty line, the cursor is assumed to be at the start of a blank row.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_init(struct render *r, int fd)
+{
+	r->fd = fd;
+	r->len = 0;
+	r->shown_len = 0;
+	r->frame_len = 0;
+	r->in_frame = 0;
+	r->id_left = 0;
+	r->keys = 0;
+	r->ndrawn = 0;
+	r->out_len = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_feed
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_feed(struct render *r, const char *data, size_t len);
+--					struct render *r:	the renderer
+--					const char *data:	bytes read from the output pipe
+--					size_t len:			number of bytes in data
+--
+-- RETURNS: void
+--
+-- NOTES: Applies echoed keys to the line being typed. The screen is only brought up to date where it has to be,
+-- when a line is ended or a translated line is drawn above it, the rest waits for render_flush.
+-- Afterwards keys holds the number of echoed keys in data, and drawn the ids of the translated lines in it.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_feed(struct render *r, const char *data, size_t len)
+{
+	r->keys = 0;
+	r->ndrawn = 0;
+
+	for(size_t i = 0; i < len; i++)
+	{
+		char c = data[i];
+
+		if(r->id_left > 0)				/* the line id in front of a translated line */
+		{
+			((unsigned char *)&r->frame_id)[sizeof(r->frame_id) - r->id_left--] = c;
+			continue;
+		}
+
+		if(r->in_frame)					/* characters of a translated line */
+		{
+			if(c == '\0')
+			{
+				draw_frame(r);
+				r->in_frame = 0;
+				if(r->ndrawn < RENDER_FRAMES)
+					r->drawn[r->ndrawn++] = r->frame_id;
+			}else
+			if(r->frame_len < RENDER_FRAME)
+				r->frame[r->frame_len++] = c;
+			continue;
+		}
+
+		switch(c)
+		{
+			case TRANS_MARK:			/* a translated line starts */
+				r->in_frame = 1;
+				r->frame_len = 0;
+				r->id_left = sizeof(r->frame_id);
+				continue;
+			case BACKSPACE:				/* 'X' erases the previous character */
+				if(r->len > 0)
+					r->len--;
+				break;
+			case LINE_KILL:				/* 'K' erases the line */
+			case HIST_RECALL:			/* the typed characters are dropped by a recall */
+			case HIST_SEARCH:
+				r->len = 0;
+				break;
+			case CARRIAGE_RETURN:		/* 'E' leaves the line on the screen and starts a new row */
+				sync_line(r);
+				put(r, "\r\n", 2);
+				r->len = 0;
+				r->shown_len = 0;
+				break;
+			default:
+				/* other control characters take no column, do not draw them */
+				if((unsigned char)c < 0x20 || c == 0x7F)
+					break;
+				if(r->len < RENDER_COLS - 1)
+					r->line[r->len++] = c;
+				break;
+		}
+		r->keys++;
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_flush(struct render *r);
+--					struct render *r: the renderer
+--
+-- RETURNS: void
+--
+-- NOTES: Brings the line on the screen up to date and writes every pending byte to the terminal in one write.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_flush(struct render *r)
+{
+	sync_line(r);
+	drain(r);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_resume
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_resume(struct render *r);
+--					struct render *r: the renderer
+--
+-- RETURNS: void
+--
+-- NOTES: Used when the output process is created again after it died. Whatever it was drawing may be half on the
+-- screen, so the line being typed is drawn again from the start of a new row by the next render_flush.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_resume(struct render *r)
+{
+	put(r, "\r\n", 2);
+	r->shown_len = 0;
+}
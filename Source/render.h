@@ -0,0 +1,147 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	render.c - Draws the output process's screen with as few bytes as possible
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void render_init(struct render *r, int fd);
+--				void render_feed(struct render *r, const char *data, size_t len);
+--				void render_flush(struct render *r);
+--				void render_resume(struct render *r);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The output pipe carries the keys echoed by the input process and the lines framed by the translate
+-- process(TRANS_MARK, the line id, the line, then a NULL). Instead of copying them to the terminal, the renderer keeps two
+-- copies of the line being typed: the line as it should look after the edit keys('X', 'K') are applied, and the
+-- line as it is on the screen now. Everything read from the pipe in one go is applied to the first copy, then the
+-- two are compared and the cheapest escape sequence is picked to bring the screen up to date: backspaces, a
+-- cursor move or a carriage return and rewrite to reach the first changed column, then erase-to-EOL or blanks for
+-- what is left over. All of it goes to the terminal in a single write.
+-- The cursor column arithmetic assumes the line being typed does not wrap on the terminal. A translated line may, it
+-- is drawn once and followed by a new row.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _RENDER_H
+#define _RENDER_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RENDER_COLS		128		/* longest line drawn, same as MSG_SIZE */
+#define RENDER_BUF		4096	/* bytes gathered before they are written to the terminal */
+#define RENDER_FRAME	PIPE_BUF	/* longest translated line drawn, same as FRAME_MAX */
+#define RENDER_FRAMES	(RENDER_BUF / 6)	/* most lines in one read, a frame takes at least 6 bytes */
+
+struct render
+{
+	int fd;							/* terminal */
+	size_t len;						/* characters in line */
+	size_t shown_len;				/* characters in shown, the cursor is right after them */
+	size_t frame_len;				/* characters in frame */
+	int in_frame;					/* set while the characters of a translated line are read */
+	size_t id_left;					/* bytes of the line id still to read */
+	uint32_t frame_id;				/* trace id of the translated line being read */
+	size_t keys;					/* keys echoed by the last render_feed */
+	size_t ndrawn;					/* translated lines drawn by the last render_feed */
+	uint32_t drawn[RENDER_FRAMES];	/* and their trace ids */
+	size_t out_len;					/* bytes waiting in out */
+	char line[RENDER_COLS];			/* line being typed, as it should look */
+	char shown[RENDER_COLS];		/* line being typed, as it is on the screen */
+	char frame[RENDER_FRAME];		/* translated line being read */
+	char out[RENDER_BUF];			/* bytes waiting to be written to the terminal */
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_init(struct render *r, int fd);
+--					struct render *r:	the renderer to set up
+--					int fd:				terminal to draw on
+--
+-- RETURNS: void
+--
+-- NOTES: Starts with an empty line, the cursor is assumed to be at the start of a blank row.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_init(struct render *r, int fd);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_feed
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_feed(struct render *r, const char *data, size_t len);
+--					struct render *r:	the renderer
+--					const char *data:	bytes read from the output pipe
+--					size_t len:			number of bytes in data
+--
+-- RETURNS: void
+--
+-- NOTES: Applies echoed keys to the line being typed. The screen is only brought up to date where it has to be,
+-- when a line is ended or a translated line is drawn above it, the rest waits for render_flush.
+-- Afterwards keys holds the number of echoed keys in data, and drawn the ids of the translated lines in it.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_feed(struct render *r, const char *data, size_t len);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_flush(struct render *r);
+--					struct render *r: the renderer
+--
+-- RETURNS: void
+--
+-- NOTES: Brings the line on the screen up to date and writes every pending byte to the terminal in one write.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_flush(struct render *r);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	render_resume
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void render_resume(struct render *r);
+--					struct render *r: the renderer
+--
+-- RETURNS: void
+--
+-- NOTES: Used when the output process is created again after it died. Whatever it was drawing may be half on the
+-- screen, so the line being typed is drawn again from the start of a new row by the next render_flush.
+--------------------------------------------------------------------------------------------------------------------*/
+void render_resume(struct render *r);
+
+#endif
@@ -0,0 +1,476 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	sources.c - Merges the keyboard and the automation inputs into one stream for the input process
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate);
+--				void sources_attach(struct sources *s);
+--				void sources_keep(struct sources *s);
+--				void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+--								  void (*on_line)(const char *line, size_t len, void *arg), void *arg);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Besides the keyboard, lines can be injected into the session by automation through a FIFO and through a
+-- local Unix socket. All of them are watched with a single epoll instance. Keyboard bytes are handed out one at a
+-- time so the input process can echo and edit them as before, automation bytes are collected in a buffer per
+-- source and only handed out as whole lines, so two sources never interleave inside a line.
+-- Each automation source has a token bucket of rate lines per second. A source that runs out of tokens is taken out
+-- of the epoll set until it earns a token again, so a noisy source can not starve the keyboard.
+-- The sources outlive the input process. They live in the shared session and are opened by the supervisor, so a
+-- restarted input process only builds a new epoll set over them, with the lines held back by the rate limit still
+-- in their buffers and the lines written to the FIFO still in the FIFO. The input process hands the supervisor a
+-- copy of every client it accepts over a socketpair(SCM_RIGHTS), and the next input process gets the client from
+-- the supervisor, so connected clients stay connected too.
+--------------------------------------------------------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "processes.h"
+#include "sources.h"
+
+static void watch_source(struct sources *s, struct source *src)
+{
+	struct epoll_event ev;
+
+	ev.events = EPOLLIN;
+	ev.data.ptr = src;
+	if(epoll_ctl(s->epfd, EPOLL_CTL_ADD, src->fd, &ev) < 0)
+		error("epoll_ctl()");
+}
+
+/* put fd in a free slot, the input process adds it to its epoll set */
+static struct source *add_source(struct sources *s, int fd, int kind)
+{
+	for(size_t i = 0; i < MAX_SOURCES; i++)
+	{
+		struct source *src = &s->src[i];
+		if(src->kind != SRC_FREE)
+			continue;
+
+		src->fd = fd;
+		src->gen = ++s->gens;
+		src->paused = 0;
+		src->discarding = 0;
+		src->tokens = s->rate;
+		src->refilled = now_ns();
+		src->len = 0;
+		src->kind = kind;
+		return src;
+	}
+	close(fd);
+	return NULL;
+}
+
+/* hand the supervisor a copy of a client, so the client outlives this process */
+static void keep_client(struct sources *s, struct source *src)
+{
+	uint32_t id[2] = { (uint32_t)(src - s->src), src->gen };
+	char ctl[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { id, sizeof(id) };
+	struct msghdr msg;
+	struct cmsghdr *cm;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(ctl, 0, sizeof(ctl));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = ctl;
+	msg.msg_controllen = sizeof(ctl);
+	cm = CMSG_FIRSTHDR(&msg);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_RIGHTS;
+	cm->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cm), &src->fd, sizeof(int));
+
+	/* without a copy the client only lasts as long as this process */
+	if(sendmsg(s->pass[1], &msg, MSG_DONTWAIT) == (ssize_t)sizeof(id))
+		kill(id_sup, SIGUSR1);
+}
+
+static void remove_source(struct sources *s, struct source *src)
+{
+	int kind = src->kind;
+
+	if(!src->paused)
+		epoll_ctl(s->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+	if(kind != SRC_KEYBOARD)
+		close(src->fd);
+	src->kind = SRC_FREE;
+
+	/* the supervisor closes its copy too */
+	if(kind == SRC_CLIENT)
+		kill(id_sup, SIGUSR1);
+}
+
+/* drop the first n bytes of buf, right away so a restarted input process never hands them out again */
+static void consume(struct source *src, size_t n)
+{
+	src->len -= n;
+	memmove(src->buf, src->buf + n, src->len);
+}
+
+static void refill(struct sources *s, struct source *src, uint64_t now)
+{
+	src->tokens += (double)(now - src->refilled) * s->rate / 1e9;
+	if(src->tokens > s->rate)
+		src->tokens = s->rate;
+	src->refilled = now;
+}
+
+/* hand out the whole lines buffered in src for as long as it has tokens */
+static void drain(struct sources *s, struct source *src, int eof,
+				  void (*on_line)(const char *line, size_t len, void *arg), void *arg)
+{
+	while(src->len > 0)
+	{
+		char *nl = memchr(src->buf, '\n', src->len);
+		size_t len = nl ? (size_t)(nl - src->buf) : src->len;
+
+		/* the rest of a cut line is dropped, it is not a line of its own */
+		if(src->discarding)
+		{
+			consume(src, nl ? len + 1 : len);
+			src->discarding = nl == NULL;
+			continue;
+		}
+		if(s->rate != 0 && src->tokens < 1)
+			break;
+
+		/* wait for the rest of a short partial line, cut a long one */
+		if(nl == NULL && len < MSG_SIZE - 1 && !eof)
+			break;
+		if(len > MSG_SIZE - 1 || (nl == NULL && len == MSG_SIZE - 1 && !eof))
+		{
+			len = MSG_SIZE - 1;
+			nl = NULL;
+			src->discarding = 1;
+		}
+
+		on_line(src->buf, (len > 0 && src->buf[len - 1] == '\r') ? len - 1 : len, arg);
+		consume(src, len + (nl != NULL));
+		src->tokens -= 1;
+	}
+
+	/* stop reading a source that is out of tokens, sources_poll will take it back */
+	if(s->rate != 0 && src->tokens < 1 && !src->paused)
+	{
+		epoll_ctl(s->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+		src->paused = 1;
+	}
+}
+
+/* bring back the paused sources that earned a token, return the ms until the next one does */
+static int resume(struct sources *s, void (*on_line)(const char *line, size_t len, void *arg), void *arg)
+{
+	int timeout = -1;
+	uint64_t now = now_ns();
+
+	for(size_t i = 0; i < MAX_SOURCES; i++)
+	{
+		struct source *src = &s->src[i];
+		if(src->kind == SRC_FREE || !src->paused)
+			continue;
+
+		refill(s, src, now);
+		if(src->tokens >= 1)
+			drain(s, src, 0, on_line, arg);
+		if(src->tokens >= 1)
+		{
+			watch_source(s, src);
+			src->paused = 0;
+		}else
+		{
+			int ms = (int)((1 - src->tokens) * 1000 / s->rate) + 1;
+			if(timeout < 0 || ms < timeout)
+				timeout = ms;
+		}
+	}
+	return timeout;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate);
+--					struct sources *s:		the sources to set up, in the shared session
+--					const char *fifo_path:	FIFO to read automation lines from, created if missing, or NULL
+--					const char *sock_path:	Unix socket to accept automation clients on, or NULL
+--					int rate:				lines per second allowed from each automation source, 0 for no limit
+--
+-- RETURNS: void
+--
+-- NOTES: Called by the supervisor before the first input process is created. Opens the FIFO and the listening
+-- socket and sets up the keyboard(stdin) and them as sources, every input process inherits them.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate)
+{
+	int fd;
+
+	for(size_t i = 0; i < MAX_SOURCES; i++)
+	{
+		s->src[i].kind = SRC_FREE;
+		s->src[i].kept = -1;
+	}
+	s->rate = rate;
+	s->gens = 0;
+	s->epfd = -1;
+
+	/* the supervisor reads the clients handed to it without blocking */
+	if(socketpair(AF_UNIX, SOCK_DGRAM, 0, s->pass) < 0)
+		error("socketpair()");
+	fcntl(s->pass[0], F_SETFL, O_NONBLOCK);
+
+	add_source(s, STDIN_FILENO, SRC_KEYBOARD);
+
+	if(fifo_path != NULL)
+	{
+		if(mkfifo(fifo_path, 0600) < 0 && errno != EEXIST)
+			error("mkfifo()");
+		/* opened for writing as well, so the FIFO never reports end of file between writers */
+		if((fd = open(fifo_path, O_RDWR | O_NONBLOCK)) < 0)
+			error("fifo open()");
+		add_source(s, fd, SRC_FIFO);
+	}
+
+	if(sock_path != NULL)
+	{
+		struct sockaddr_un addr;
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+		unlink(sock_path);
+
+		if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0)
+			error("socket()");
+		if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+			error("bind()");
+		if(listen(fd, MAX_SOURCES) < 0)
+			error("listen()");
+		add_source(s, fd, SRC_LISTEN);
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_attach
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_attach(struct sources *s);
+--					struct sources *s: the sources opened by sources_open
+--
+-- RETURNS: void
+--
+-- NOTES: Called by every input process before sources_poll. Creates its epoll set and adds the sources that are not
+-- paused. A client accepted by an input process that died is taken over from the supervisor's copy, which is
+-- inherited, and a client the supervisor has no copy of is dropped.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_attach(struct sources *s)
+{
+	if((s->epfd = epoll_create1(0)) < 0)
+		error("epoll_create1()");
+
+	for(size_t i = 0; i < MAX_SOURCES; i++)
+	{
+		struct source *src = &s->src[i];
+
+		if(src->kind == SRC_CLIENT)
+		{
+			if(src->kept < 0 || src->kept_gen != src->gen)
+			{
+				src->kind = SRC_FREE;
+				continue;
+			}
+			src->fd = src->kept;
+		}
+		if(src->kind != SRC_FREE && !src->paused)
+			watch_source(s, src);
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_keep
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_keep(struct sources *s);
+--					struct sources *s: the sources opened by sources_open
+--
+-- RETURNS: void
+--
+-- NOTES: Called by the supervisor whenever the input process signals it(SIGUSR1) and before a new input process is
+-- created. Takes the copies of the clients handed over since the last call and closes the copies of the clients
+-- that went away.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_keep(struct sources *s)
+{
+	uint32_t id[2];
+	char ctl[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { id, sizeof(id) };
+	struct msghdr msg;
+	struct cmsghdr *cm;
+	int fd;
+
+	/* the copies handed over since the last call */
+	while(1)
+	{
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = ctl;
+		msg.msg_controllen = sizeof(ctl);
+		if(recvmsg(s->pass[0], &msg, 0) < 0)
+			break;
+		if((cm = CMSG_FIRSTHDR(&msg)) == NULL || cm->cmsg_type != SCM_RIGHTS)
+			continue;
+		memcpy(&fd, CMSG_DATA(cm), sizeof(int));
+		if(id[0] >= MAX_SOURCES)
+		{
+			close(fd);
+			continue;
+		}
+		if(s->src[id[0]].kept >= 0)
+			close(s->src[id[0]].kept);
+		s->src[id[0]].kept = fd;
+		s->src[id[0]].kept_gen = id[1];
+	}
+
+	/* a copy whose client is no longer in its slot */
+	for(size_t i = 0; i < MAX_SOURCES; i++)
+	{
+		struct source *src = &s->src[i];
+		if(src->kept >= 0 && (src->kind != SRC_CLIENT || src->gen != src->kept_gen))
+		{
+			close(src->kept);
+			src->kept = -1;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_poll
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+--								  void (*on_line)(const char *line, size_t len, void *arg), void *arg);
+--					struct sources *s:	the sources to wait on
+--					on_key:				called for every byte read from the keyboard
+--					on_line:			called for every whole line read from an automation source
+--					void *arg:			passed through to on_key and on_line
+--
+-- RETURNS: void
+--
+-- NOTES: Waits until at least one source is readable or a paused source earns a token, then hands out everything
+-- that arrived in arrival order. Lines are given without their '\n' and are cut at MSG_SIZE - 1 characters, the
+-- rest of a cut line is dropped.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+				  void (*on_line)(const char *line, size_t len, void *arg), void *arg)
+{
+	struct epoll_event ev[MAX_SOURCES];
+	int n, fd, timeout;
+	ssize_t got;
+
+	timeout = resume(s, on_line, arg);
+	if((n = epoll_wait(s->epfd, ev, MAX_SOURCES, timeout)) < 0)
+	{
+		if(errno != EINTR)
+			error("epoll_wait()");
+		return;
+	}
+
+	for(int i = 0; i < n; i++)
+	{
+		struct source *src = ev[i].data.ptr;
+
+		switch(src->kind)
+		{
+			case SRC_KEYBOARD:
+			{
+				char keys[MSG_SIZE];
+				if((got = read(src->fd, keys, sizeof(keys))) <= 0)
+				{
+					if(got < 0 && errno == EINTR)
+						break;
+					remove_source(s, src);		/* stdin closed */
+					break;
+				}
+				for(ssize_t k = 0; k < got; k++)
+					on_key(keys[k], arg);
+				break;
+			}
+			case SRC_LISTEN:
+			{
+				struct source *client;
+				if((fd = accept4(src->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0
+					&& (client = add_source(s, fd, SRC_CLIENT)) != NULL)
+				{
+					keep_client(s, client);
+					watch_source(s, client);
+				}
+				break;
+			}
+			case SRC_FIFO:
+			case SRC_CLIENT:
+				refill(s, src, now_ns());
+				if(src->len == SRC_BUF_SIZE)
+					break;
+				got = read(src->fd, src->buf + src->len, SRC_BUF_SIZE - src->len);
+				if(got < 0 && (errno == EAGAIN || errno == EINTR))
+					break;
+				if(got > 0)
+				{
+					src->len += got;
+					drain(s, src, 0, on_line, arg);
+				}else
+				{
+					/* hand out what is left of a client that went away */
+					drain(s, src, 1, on_line, arg);
+					if(src->len == 0)
+						remove_source(s, src);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+}
@@ -0,0 +1,169 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	sources.c - Merges the keyboard and the automation inputs into one stream for the input process
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate);
+--				void sources_attach(struct sources *s);
+--				void sources_keep(struct sources *s);
+--				void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+--								  void (*on_line)(const char *line, size_t len, void *arg), void *arg);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Besides the keyboard, lines can be injected into the session by automation through a FIFO and through a
+-- local Unix socket. All of them are watched with a single epoll instance. Keyboard bytes are handed out one at a
+-- time so the input process can echo and edit them as before, automation bytes are collected in a buffer per
+-- source and only handed out as whole lines, so two sources never interleave inside a line.
+-- Each automation source has a token bucket of rate lines per second. A source that runs out of tokens is taken out
+-- of the epoll set until it earns a token again, so a noisy source can not starve the keyboard.
+-- The sources outlive the input process. They live in the shared session and are opened by the supervisor, so a
+-- restarted input process only builds a new epoll set over them, with the lines held back by the rate limit still
+-- in their buffers and the lines written to the FIFO still in the FIFO. The input process hands the supervisor a
+-- copy of every client it accepts over a socketpair(SCM_RIGHTS), and the next input process gets the client from
+-- the supervisor, so connected clients stay connected too.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _SOURCES_H
+#define _SOURCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_SOURCES		16		/* keyboard, fifo, socket listener and socket clients */
+#define SRC_BUF_SIZE	4096	/* bytes buffered per automation source */
+#define SRC_RATE		50		/* default lines per second allowed from one automation source */
+
+/* kinds of source */
+#define SRC_FREE		0
+#define SRC_KEYBOARD	1
+#define SRC_FIFO		2
+#define SRC_LISTEN		3
+#define SRC_CLIENT		4
+
+struct source
+{
+	int fd;
+	int kind;
+	uint32_t gen;			/* tells a client from the one that had the slot before it */
+	int kept;				/* the supervisor's copy of a client, -1 when it has none */
+	uint32_t kept_gen;		/* gen of the client of kept */
+	int paused;				/* out of the epoll set until it earns a token */
+	int discarding;			/* the line being read was cut, its bytes are dropped up to the next '\n' */
+	double tokens;			/* lines this source may send right now */
+	uint64_t refilled;		/* monotonic time of the last refill, in nanoseconds */
+	size_t len;				/* bytes waiting in buf */
+	char buf[SRC_BUF_SIZE];
+};
+
+struct sources
+{
+	int epfd;				/* epoll set of the running input process */
+	int rate;				/* lines per second per automation source, 0 for no limit */
+	int pass[2];			/* socketpair the input process hands accepted clients to the supervisor over */
+	uint32_t gens;			/* clients accepted so far */
+	struct source src[MAX_SOURCES];
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate);
+--					struct sources *s:		the sources to set up, in the shared session
+--					const char *fifo_path:	FIFO to read automation lines from, created if missing, or NULL
+--					const char *sock_path:	Unix socket to accept automation clients on, or NULL
+--					int rate:				lines per second allowed from each automation source, 0 for no limit
+--
+-- RETURNS: void
+--
+-- NOTES: Called by the supervisor before the first input process is created. Opens the FIFO and the listening
+-- socket and sets up the keyboard(stdin) and them as sources, every input process inherits them.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_open(struct sources *s, const char *fifo_path, const char *sock_path, int rate);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_attach
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_attach(struct sources *s);
+--					struct sources *s: the sources opened by sources_open
+--
+-- RETURNS: void
+--
+-- NOTES: Called by every input process before sources_poll. Creates its epoll set and adds the sources that are not
+-- paused. A client accepted by an input process that died is taken over from the supervisor's copy, which is
+-- inherited, and a client the supervisor has no copy of is dropped.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_attach(struct sources *s);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_keep
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_keep(struct sources *s);
+--					struct sources *s: the sources opened by sources_open
+--
+-- RETURNS: void
+--
+-- NOTES: Called by the supervisor whenever the input process signals it(SIGUSR1) and before a new input process is
+-- created. Takes the copies of the clients handed over since the last call and closes the copies of the clients
+-- that went away.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_keep(struct sources *s);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	sources_poll
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+--								  void (*on_line)(const char *line, size_t len, void *arg), void *arg);
+--					struct sources *s:	the sources to wait on
+--					on_key:				called for every byte read from the keyboard
+--					on_line:			called for every whole line read from an automation source
+--					void *arg:			passed through to on_key and on_line
+--
+-- RETURNS: void
+--
+-- NOTES: Waits until at least one source is readable or a paused source earns a token, then hands out everything
+-- that arrived in arrival order. Lines are given without their '\n' and are cut at MSG_SIZE - 1 characters, the
+-- rest of a cut line is dropped.
+--------------------------------------------------------------------------------------------------------------------*/
+void sources_poll(struct sources *s, void (*on_key)(char c, void *arg),
+				  void (*on_line)(const char *line, size_t len, void *arg), void *arg);
+
+#endif
@@ -0,0 +1,550 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	subst.c - Multi-pattern substitution of translated lines, built into libtranslate.a
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	struct subst *subst_load(const char *path);
+--				size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size);
+--				size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp);
+--				void subst_free(struct subst *s);
+--				void subst_watch_start(struct subst_watch *w, const char *path);
+--				const struct subst *subst_current(struct subst_watch *w);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Rewrites tokens of any length in a translated line, such as abbreviations that expand to commands or
+-- strings that have to be masked. The pattern file holds one "pattern<TAB>replacement" per line, blank lines and
+-- lines starting with '#' are skipped, and the replacement may be empty.
+-- The patterns are compiled into an Aho-Corasick automaton. Only the bytes that appear in some pattern get a class
+-- of their own, every other byte shares class 0, and the goto and failure functions are folded into one dense
+-- table of states * classes entries, so a step is one table load whatever the number of patterns. A line is
+-- scanned once: for every position the longest pattern starting there is found through the dictionary links of
+-- the states, then the line is copied with the leftmost, longest matches replaced and no match overlapping another.
+-- A compiled automaton is never changed, so one automaton can be used by any number of threads at once.
+-- subst_watch keeps the automaton up to date with the file. A thread polls the file every SUBST_POLL_MS, compiles
+-- the new list when it changes and hands it over through an atomic pointer, the caller only swaps it in.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "subst.h"
+
+/* one pattern of the list */
+struct subst_pat
+{
+	uint32_t len;				/* characters in the pattern */
+	uint32_t rep_off;			/* replacement in text */
+	uint32_t rep_len;
+};
+
+struct subst
+{
+	uint32_t nstates;
+	uint32_t nclass;			/* byte classes, class 0 is every byte that is in no pattern */
+	uint16_t cls[256];			/* class of each byte */
+	uint32_t *next;				/* next state, nstates rows of nclass entries */
+	int32_t *pat;				/* pattern that ends at a state, -1 for none */
+	uint32_t *dict;				/* nearest state on the failure chain where a pattern ends, 0 for none */
+	struct subst_pat *pats;
+	char *text;					/* replacements */
+};
+
+/* one "pattern<TAB>replacement" line of the file */
+struct subst_line
+{
+	const char *pat, *rep;
+	size_t pat_len, rep_len;
+};
+
+/* read the whole file into a NULL terminated buffer */
+static char *read_file(const char *path, size_t *size)
+{
+	struct stat st;
+	char *buf;
+	ssize_t n;
+	int fd, err;
+
+	if((fd = open(path, O_RDONLY)) < 0)
+		return NULL;
+	if(fstat(fd, &st) < 0 || (buf = malloc(st.st_size + 1)) == NULL)
+	{
+		err = errno;
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+	*size = 0;
+	while((n = read(fd, buf + *size, st.st_size - *size)) > 0)
+		*size += n;
+	err = errno;
+	close(fd);
+	if(n < 0)
+	{
+		free(buf);
+		errno = err;
+		return NULL;
+	}
+	buf[*size] = '\0';
+	return buf;
+}
+
+/* split the file into its pattern lines, returns how many there are */
+static size_t parse(char *buf, size_t size, struct subst_line *lines)
+{
+	size_t count = 0;
+	char *p = buf, *end = buf + size;
+
+	while(p < end)
+	{
+		char *eol = memchr(p, '\n', end - p), *tab;
+		size_t len;
+
+		if(eol == NULL)
+			eol = end;
+		len = eol - p;
+		if(len > 0 && p[len - 1] == '\r')
+			len--;
+
+		if(len > 0 && p[0] != '#' && (tab = memchr(p, '\t', len)) != NULL && tab > p
+			&& (size_t)(tab - p) <= SUBST_LINE_MAX)
+		{
+			lines[count].pat = p;
+			lines[count].pat_len = tab - p;
+			lines[count].rep = tab + 1;
+			lines[count].rep_len = len - (tab + 1 - p);
+			count++;
+		}
+		p = eol + 1;
+	}
+	return count;
+}
+
+/* compile the patterns into the dense automaton */
+static int build(struct subst *s, const struct subst_line *lines, size_t count)
+{
+	size_t max_states = 1, text_len = 0, npats = 0, head = 0, tail = 0;
+	uint32_t *fail, *queue, nc;
+
+	/* every byte used by a pattern gets a class of its own */
+	s->nclass = 1;
+	for(size_t i = 0; i < count; i++)
+	{
+		for(size_t j = 0; j < lines[i].pat_len; j++)
+			if(s->cls[(unsigned char)lines[i].pat[j]] == 0)
+				s->cls[(unsigned char)lines[i].pat[j]] = s->nclass++;
+		max_states += lines[i].pat_len;
+		text_len += lines[i].rep_len;
+	}
+	nc = s->nclass;
+
+	s->next = calloc(max_states * nc, sizeof(*s->next));
+	s->pat = malloc(max_states * sizeof(*s->pat));
+	s->dict = calloc(max_states, sizeof(*s->dict));
+	s->pats = malloc((count + 1) * sizeof(*s->pats));
+	s->text = malloc(text_len + 1);
+	fail = calloc(max_states, sizeof(*fail));
+	queue = malloc(max_states * sizeof(*queue));
+	if(s->next == NULL || s->pat == NULL || s->dict == NULL || s->pats == NULL || s->text == NULL
+		|| fail == NULL || queue == NULL)
+	{
+		free(fail);
+		free(queue);
+		errno = ENOMEM;
+		return -1;
+	}
+	for(size_t i = 0; i < max_states; i++)
+		s->pat[i] = -1;
+
+	/* the trie, 0 is the root and also stands for a missing edge since no edge leads back to the root */
+	s->nstates = 1;
+	text_len = 0;
+	for(size_t i = 0; i < count; i++)
+	{
+		uint32_t st = 0;
+
+		for(size_t j = 0; j < lines[i].pat_len; j++)
+		{
+			uint32_t *edge = &s->next[st * nc + s->cls[(unsigned char)lines[i].pat[j]]];
+			if(*edge == 0)
+				*edge = s->nstates++;
+			st = *edge;
+		}
+		if(s->pat[st] >= 0)
+			continue;
+
+		s->pat[st] = npats;
+		s->pats[npats].len = lines[i].pat_len;
+		s->pats[npats].rep_off = text_len;
+		s->pats[npats].rep_len = lines[i].rep_len;
+		memcpy(s->text + text_len, lines[i].rep, lines[i].rep_len);
+		text_len += lines[i].rep_len;
+		npats++;
+	}
+
+	/* breadth first, fill in the missing edges from the failure state, which is always done already */
+	for(uint32_t c = 0; c < nc; c++)
+		if(s->next[c] != 0)
+			queue[tail++] = s->next[c];
+	while(head < tail)
+	{
+		uint32_t st = queue[head++], *row = &s->next[st * nc], *frow = &s->next[fail[st] * nc];
+
+		for(uint32_t c = 0; c < nc; c++)
+		{
+			uint32_t u = row[c];
+
+			if(u == 0)
+			{
+				row[c] = frow[c];
+				continue;
+			}
+			fail[u] = frow[c];
+			s->dict[u] = s->pat[fail[u]] >= 0 ? fail[u] : s->dict[fail[u]];
+			queue[tail++] = u;
+		}
+	}
+	free(fail);
+	free(queue);
+	return 0;
+}
+
+/* subst_watch: compile the file again if it is not the one compiled last */
+static void reload(struct subst_watch *w)
+{
+	struct stat st;
+	struct subst *s;
+
+	if(stat(w->path, &st) < 0)
+		return;
+	if(st.st_dev == w->st.st_dev && st.st_ino == w->st.st_ino && st.st_size == w->st.st_size
+		&& st.st_mtim.tv_sec == w->st.st_mtim.tv_sec && st.st_mtim.tv_nsec == w->st.st_mtim.tv_nsec)
+		return;
+	w->st = st;
+
+	if((s = subst_load(w->path)) == NULL)
+	{
+		perror(w->path);
+		return;
+	}
+	/* a list the caller never swapped in was never used */
+	subst_free(atomic_exchange(&w->pending, s));
+}
+
+/* one pass over the line: best[i] is the length of the longest match starting at i, 0 for none, which[i] its pattern */
+static void scan(const struct subst *s, const char *in, size_t len, uint8_t *best, int32_t *which)
+{
+	uint32_t st = 0, nc = s->nclass;
+
+	memset(best, 0, len);
+	for(size_t i = 0; i < len; i++)
+	{
+		/* every pattern that ends here is on the dictionary chain of the state */
+		st = s->next[st * nc + s->cls[(unsigned char)in[i]]];
+		for(uint32_t t = s->pat[st] >= 0 ? st : s->dict[st]; t != 0; t = s->dict[t])
+		{
+			int32_t p = s->pat[t];
+			size_t start = i + 1 - s->pats[p].len;
+
+			if(s->pats[p].len > best[start])
+			{
+				best[start] = s->pats[p].len;
+				which[start] = p;
+			}
+		}
+	}
+}
+
+static void *watch(void *arg)
+{
+	struct timespec ts = { SUBST_POLL_MS / 1000, (SUBST_POLL_MS % 1000) * 1000000L };
+
+	while(1)
+	{
+		nanosleep(&ts, NULL);
+		reload(arg);
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_load
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	struct subst *subst_load(const char *path);
+--					const char *path: pattern file to compile
+--
+-- RETURNS: the compiled automaton, NULL with errno set if the file could not be read
+--
+-- NOTES: Patterns longer than SUBST_LINE_MAX can never match and are skipped. When the same pattern is given twice
+-- the first replacement is used.
+--------------------------------------------------------------------------------------------------------------------*/
+struct subst *subst_load(const char *path)
+{
+	struct subst_line *lines;
+	struct subst *s;
+	size_t size, count;
+	char *buf;
+	int err;
+
+	if((buf = read_file(path, &size)) == NULL)
+		return NULL;
+
+	/* a line holds at least a pattern character and a TAB */
+	lines = malloc((size / 2 + 1) * sizeof(*lines));
+	s = calloc(1, sizeof(*s));
+	if(lines == NULL || s == NULL)
+	{
+		free(buf);
+		free(lines);
+		free(s);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	count = parse(buf, size, lines);
+	if(build(s, lines, count) < 0)
+	{
+		err = errno;
+		subst_free(s);
+		s = NULL;
+		errno = err;
+	}
+	free(lines);
+	free(buf);
+	return s;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_apply
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size);
+--					const struct subst *s:	the automaton
+--					const char *in:			line to substitute
+--					size_t len:				characters in the line, the ones past SUBST_LINE_MAX are dropped
+--					char *out:				buffer the substituted line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut and reported by the return value
+--
+-- RETURNS: the length of the whole substituted line, like snprintf(). When it is out_size or more the line was cut
+-- to out_size - 1 characters.
+--
+-- NOTES: in and out must not overlap. Calling it with an out_size of 0 only measures the line.
+--------------------------------------------------------------------------------------------------------------------*/
+size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size)
+{
+	uint8_t best[SUBST_LINE_MAX];		/* longest match starting at each position */
+	int32_t which[SUBST_LINE_MAX];		/* and its pattern */
+	size_t o = 0, room = out_size > 0 ? out_size - 1 : 0;
+
+	if(len > SUBST_LINE_MAX)
+		len = SUBST_LINE_MAX;
+	scan(s, in, len, best, which);
+
+	/* copy the line, replacing the leftmost longest matches, and keep counting once out is full */
+	for(size_t i = 0; i < len; )
+	{
+		if(best[i] == 0)
+		{
+			if(o < room)
+				out[o] = in[i];
+			o++;
+			i++;
+			continue;
+		}
+
+		const struct subst_pat *p = &s->pats[which[i]];
+		if(o < room)
+			memcpy(out + o, s->text + p->rep_off, p->rep_len < room - o ? p->rep_len : room - o);
+		o += p->rep_len;
+		i += best[i];
+	}
+	if(out_size > 0)
+		out[o < room ? o : room] = '\0';
+	return o;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_write
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp);
+--					const struct subst *s:	the automaton
+--					const char *in:			line to substitute
+--					size_t len:				characters in the line, the ones past SUBST_LINE_MAX are dropped
+--					FILE *fp:				stream the substituted line is written to
+--
+-- RETURNS: the number of characters written
+--
+-- NOTES: Same as subst_apply, but the line goes straight to the stream, so it is never cut however long the
+-- replacements make it. The unchanged runs and the replacements are written as they are, no line is built.
+--------------------------------------------------------------------------------------------------------------------*/
+size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp)
+{
+	uint8_t best[SUBST_LINE_MAX];		/* longest match starting at each position */
+	int32_t which[SUBST_LINE_MAX];		/* and its pattern */
+	size_t run = 0, o = 0;
+
+	if(len > SUBST_LINE_MAX)
+		len = SUBST_LINE_MAX;
+	scan(s, in, len, best, which);
+
+	for(size_t i = 0; i < len; )
+	{
+		if(best[i] == 0)
+		{
+			i++;
+			continue;
+		}
+
+		/* the unchanged characters before the match, then its replacement */
+		const struct subst_pat *p = &s->pats[which[i]];
+		fwrite(in + run, 1, i - run, fp);
+		fwrite(s->text + p->rep_off, 1, p->rep_len, fp);
+		o += i - run + p->rep_len;
+		i += best[i];
+		run = i;
+	}
+	fwrite(in + run, 1, len - run, fp);
+	return o + len - run;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_free
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void subst_free(struct subst *s);
+--					struct subst *s: the automaton, may be NULL
+--
+-- RETURNS: void
+--------------------------------------------------------------------------------------------------------------------*/
+void subst_free(struct subst *s)
+{
+	if(s == NULL)
+		return;
+	free(s->next);
+	free(s->pat);
+	free(s->dict);
+	free(s->pats);
+	free(s->text);
+	free(s);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_watch_start
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void subst_watch_start(struct subst_watch *w, const char *path);
+--					struct subst_watch *w:	the watch to start
+--					const char *path:		pattern file, nothing is substituted when NULL
+--
+-- RETURNS: void
+--
+-- NOTES: Compiles the file right away, then starts the thread that compiles it again whenever its size, time or
+-- inode changes, so a file replaced by an editor is picked up too. A list that can not be read is reported on
+-- stderr and the previous one is kept. The thread blocks every signal, signals are left to the caller's thread.
+--------------------------------------------------------------------------------------------------------------------*/
+void subst_watch_start(struct subst_watch *w, const char *path)
+{
+	sigset_t all, old;
+	int err;
+
+	w->path = path;
+	w->current = NULL;
+	atomic_init(&w->pending, NULL);
+	memset(&w->st, 0, sizeof(w->st));
+	if(path == NULL)
+		return;
+
+	reload(w);
+	w->current = atomic_exchange(&w->pending, NULL);
+
+	/* the thread inherits the signal mask, so every signal goes to the caller */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	if((err = pthread_create(&w->thread, NULL, watch, w)) != 0)
+		fprintf(stderr, "pthread_create(): %s\n", strerror(err));
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_current
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const struct subst *subst_current(struct subst_watch *w);
+--					struct subst_watch *w: the watch
+--
+-- RETURNS: the newest automaton, NULL when there is none
+--
+-- NOTES: Called once per line by the thread that started the watch. Swaps in the automaton compiled since the last
+-- call, if there is one, and frees the one it replaces, which no other thread uses. The pointer is good until the
+-- next call.
+--------------------------------------------------------------------------------------------------------------------*/
+const struct subst *subst_current(struct subst_watch *w)
+{
+	struct subst *s;
+
+	/* a plain load on the hot path, the exchange only happens once per reload */
+	if(atomic_load_explicit(&w->pending, memory_order_acquire) != NULL
+		&& (s = atomic_exchange(&w->pending, NULL)) != NULL)
+	{
+		subst_free(w->current);
+		w->current = s;
+	}
+	return w->current;
+}
@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	subst.c - Multi-pattern substitution of translated lines, built into libtranslate.a
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	struct subst *subst_load(const char *path);
+--				size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size);
+--				size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp);
+--				void subst_free(struct subst *s);
+--				void subst_watch_start(struct subst_watch *w, const char *path);
+--				const struct subst *subst_current(struct subst_watch *w);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: Rewrites tokens of any length in a translated line, such as abbreviations that expand to commands or
+-- strings that have to be masked. The pattern file holds one "pattern<TAB>replacement" per line, blank lines and
+-- lines starting with '#' are skipped, and the replacement may be empty.
+-- The patterns are compiled into an Aho-Corasick automaton. Only the bytes that appear in some pattern get a class
+-- of their own, every other byte shares class 0, and the goto and failure functions are folded into one dense
+-- table of states * classes entries, so a step is one table load whatever the number of patterns. A line is
+-- scanned once: for every position the longest pattern starting there is found through the dictionary links of
+-- the states, then the line is copied with the leftmost, longest matches replaced and no match overlapping another.
+-- A compiled automaton is never changed, so one automaton can be used by any number of threads at once.
+-- subst_watch keeps the automaton up to date with the file. A thread polls the file every SUBST_POLL_MS, compiles
+-- the new list when it changes and hands it over through an atomic pointer, the caller only swaps it in.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _SUBST_H
+#define _SUBST_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#define SUBST_LINE_MAX	128		/* longest line substituted, same as TR_LINE_SIZE */
+#define SUBST_POLL_MS	500		/* how often the pattern file is checked for changes */
+
+struct subst;
+
+struct subst_watch
+{
+	const char *path;					/* pattern file */
+	struct stat st;						/* the file when it was last compiled */
+	struct subst *current;				/* automaton used by the caller */
+	_Atomic(struct subst *) pending;	/* automaton compiled but not swapped in yet */
+	pthread_t thread;
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_load
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	struct subst *subst_load(const char *path);
+--					const char *path: pattern file to compile
+--
+-- RETURNS: the compiled automaton, NULL with errno set if the file could not be read
+--
+-- NOTES: Patterns longer than SUBST_LINE_MAX can never match and are skipped. When the same pattern is given twice
+-- the first replacement is used.
+--------------------------------------------------------------------------------------------------------------------*/
+struct subst *subst_load(const char *path);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_apply
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size);
+--					const struct subst *s:	the automaton
+--					const char *in:			line to substitute
+--					size_t len:				characters in the line, the ones past SUBST_LINE_MAX are dropped
+--					char *out:				buffer the substituted line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut and reported by the return value
+--
+-- RETURNS: the length of the whole substituted line, like snprintf(). When it is out_size or more the line was cut
+-- to out_size - 1 characters.
+--
+-- NOTES: in and out must not overlap. Calling it with an out_size of 0 only measures the line.
+--------------------------------------------------------------------------------------------------------------------*/
+size_t subst_apply(const struct subst *s, const char *in, size_t len, char *out, size_t out_size);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_write
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp);
+--					const struct subst *s:	the automaton
+--					const char *in:			line to substitute
+--					size_t len:				characters in the line, the ones past SUBST_LINE_MAX are dropped
+--					FILE *fp:				stream the substituted line is written to
+--
+-- RETURNS: the number of characters written
+--
+-- NOTES: Same as subst_apply, but the line goes straight to the stream, so it is never cut however long the
+-- replacements make it. The unchanged runs and the replacements are written as they are, no line is built.
+--------------------------------------------------------------------------------------------------------------------*/
+size_t subst_write(const struct subst *s, const char *in, size_t len, FILE *fp);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_free
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void subst_free(struct subst *s);
+--					struct subst *s: the automaton, may be NULL
+--
+-- RETURNS: void
+--------------------------------------------------------------------------------------------------------------------*/
+void subst_free(struct subst *s);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_watch_start
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void subst_watch_start(struct subst_watch *w, const char *path);
+--					struct subst_watch *w:	the watch to start
+--					const char *path:		pattern file, nothing is substituted when NULL
+--
+-- RETURNS: void
+--
+-- NOTES: Compiles the file right away, then starts the thread that compiles it again whenever its size, time or
+-- inode changes, so a file replaced by an editor is picked up too. A list that can not be read is reported on
+-- stderr and the previous one is kept. The thread blocks every signal, signals are left to the caller's thread.
+--------------------------------------------------------------------------------------------------------------------*/
+void subst_watch_start(struct subst_watch *w, const char *path);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	subst_current
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	const struct subst *subst_current(struct subst_watch *w);
+--					struct subst_watch *w: the watch
+--
+-- RETURNS: the newest automaton, NULL when there is none
+--
+-- NOTES: Called once per line by the thread that started the watch. Swaps in the automaton compiled since the last
+-- call, if there is one, and frees the one it replaces, which no other thread uses. The pointer is good until the
+-- next call.
+--------------------------------------------------------------------------------------------------------------------*/
+const struct subst *subst_current(struct subst_watch *w);
+
+#endif
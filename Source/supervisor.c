@@ -0,0 +1,200 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	supervisor.c - Runs the three processes and restarts the ones that die
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void session_open(void);
+--				void supervise(int pipe_in_trans[2], int pipe_in_out[2]);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The parent process no longer reads the keyboard itself. It creates the input, translate and output
+-- processes and waits for them with waitpid(). The state of the session that has to outlive a process (the line
+-- being typed, the line history, the input sources, the translator context and the screen model) is kept in a
+-- shared mapping made before the first fork, and the parent keeps both ends of both pipes open, so the messages
+-- queued in a pipe are not lost when the process reading it dies. The same way it opens the automation FIFO and
+-- listening socket itself and keeps a copy of every connected client, see sources.c. When a process dies on its
+-- own, only that process is created again and it carries on from the shared state. A process that dies more than
+-- SUP_MAX_RESTARTS times within any one second ends the session, the last restarts of each process are kept with
+-- the monotonic clock.
+-- The normal and abnormal terminate keys, and error(), still end the whole session through handle_signal. The
+-- handler only kills the processes, the supervisor reaps them and writes the trace once they are all gone.
+--------------------------------------------------------------------------------------------------------------------*/
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "supervisor.h"
+
+struct session *session = NULL;
+
+/* one of the three processes */
+struct stage
+{
+	pid_t *id;
+	uint64_t restarts[SUP_MAX_RESTARTS];	/* monotonic time of the last restarts, in nanoseconds */
+	int next;								/* oldest of them, the next one replaced */
+};
+
+/* SIGUSR1 only interrupts waitpid(), so the loop takes the clients the input process handed over */
+static void wake(int sig)
+{
+	(void)sig;
+}
+
+/* create the process of a stage, which never returns from its handle_ function */
+static void spawn(pid_t *id, int pipe_in_trans[2], int pipe_in_out[2])
+{
+	sigset_t term, old;
+
+	/* no new process once the session is ending, handle_signal can not run between the check and the fork */
+	sigemptyset(&term);
+	sigaddset(&term, SIGTERM);
+	sigaddset(&term, SIGABRT);
+	sigprocmask(SIG_BLOCK, &term, &old);
+	if(end_signal != 0 || create_process(id) != 0)
+	{
+		sigprocmask(SIG_SETMASK, &old, NULL);
+		return;
+	}
+	sigprocmask(SIG_SETMASK, &old, NULL);
+
+	if(id == &id_in)
+		handle_input(pipe_in_trans, pipe_in_out);
+	else if(id == &id_trans)
+		handle_translate(pipe_in_trans, pipe_in_out);
+	else
+		handle_output(pipe_in_out);
+	exit(EXIT_SUCCESS);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	session_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void session_open(void);
+--
+-- RETURNS: void
+--
+-- NOTES: Maps the shared session state and starts an empty session, opening the input sources of the options. Has
+-- to be called before the processes are created.
+--------------------------------------------------------------------------------------------------------------------*/
+void session_open(void)
+{
+	void *p = mmap(NULL, sizeof(struct session), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(p == MAP_FAILED)
+		error("session mmap()");
+	session = p;
+
+	session->in.index = 0;
+	session->in.recall = 0;
+	session->in.keys = 0;
+	session->in.lines = 0;
+	init_empty_buf(session->in.msg);
+	history_init(&session->hist);
+	translator_init(&session->tr);
+	render_init(&session->scr, STDOUT_FILENO);
+	session->echoed = 0;
+	session->chunks = 0;
+	sources_open(&session->srcs, opts.fifo_path, opts.sock_path, opts.rate);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	supervise
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void supervise(int pipe_in_trans[2], int pipe_in_out[2]);
+--					int pipe_in_trans[2]:	pipe from the input process to the translate process
+--					int pipe_in_out[2]: 	pipe from the input and translate processes to the output process
+--
+-- RETURNS: void, only once the session ends
+--
+-- NOTES: Creates the three processes, then waits for them and creates again any process that dies. The input
+-- process wakes it(SIGUSR1) when it accepts or drops a client, so the supervisor's copies follow. Once
+-- handle_signal has killed them to end the session, reaps all three, writes the trace file and ends the supervisor
+-- with the same signal.
+--------------------------------------------------------------------------------------------------------------------*/
+void supervise(int pipe_in_trans[2], int pipe_in_out[2])
+{
+	struct stage stages[3] = { { .id = &id_trans }, { .id = &id_out }, { .id = &id_in } };
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = wake;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	for(int i = 0; i < 3; i++)
+		spawn(stages[i].id, pipe_in_trans, pipe_in_out);
+
+	while(1)
+	{
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		struct stage *st = NULL;
+		uint64_t now = now_ns();
+
+		/* handle_signal killed the processes, this is one of them or the interrupted wait */
+		if(end_signal != 0)
+			break;
+		if(pid < 0 && errno != EINTR)
+			error("waitpid()");
+
+		/* woken by the input process or by a process that died, the copies of the clients follow either way */
+		sources_keep(&session->srcs);
+		if(pid < 0)
+			continue;
+
+		for(int i = 0; i < 3; i++)
+			if(*stages[i].id == pid)
+				st = &stages[i];
+		if(st == NULL)
+			continue;
+
+		/* a process that keeps dying right away is not going to get better: this would be one restart too many
+		   if the oldest of the last SUP_MAX_RESTARTS was less than a second ago */
+		if(st->restarts[st->next] != 0 && now - st->restarts[st->next] < 1000000000u)
+		{
+			kill(getpid(), SIGTERM);
+			continue;
+		}
+		st->restarts[st->next] = now;
+		st->next = (st->next + 1) % SUP_MAX_RESTARTS;
+
+		/* the screen may hold half of an update, carry on from a new row */
+		if(st->id == &id_out)
+			render_resume(&session->scr);
+
+		spawn(st->id, pipe_in_trans, pipe_in_out);
+	}
+
+	/* nothing writes to the trace rings once the processes are reaped, and the file is written outside the handler */
+	while(waitpid(-1, NULL, 0) > 0 || errno == EINTR)
+		;
+	trace_flush(opts.trace_path);
+
+	/* end the supervisor with the signal that ended the session */
+	toogle_termproc(ON);
+	signal(end_signal, SIG_DFL);
+	kill(getpid(), end_signal);
+}
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	supervisor.c - Runs the three processes and restarts the ones that die
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void session_open(void);
+--				void supervise(int pipe_in_trans[2], int pipe_in_out[2]);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The parent process no longer reads the keyboard itself. It creates the input, translate and output
+-- processes and waits for them with waitpid(). The state of the session that has to outlive a process (the line
+-- being typed, the line history, the input sources, the translator context and the screen model) is kept in a
+-- shared mapping made before the first fork, and the parent keeps both ends of both pipes open, so the messages
+-- queued in a pipe are not lost when the process reading it dies. The same way it opens the automation FIFO and
+-- listening socket itself and keeps a copy of every connected client, see sources.c. When a process dies on its
+-- own, only that process is created again and it carries on from the shared state. A process that dies more than
+-- SUP_MAX_RESTARTS times within any one second ends the session, the last restarts of each process are kept with
+-- the monotonic clock.
+-- The normal and abnormal terminate keys, and error(), still end the whole session through handle_signal. The
+-- handler only kills the processes, the supervisor reaps them and writes the trace once they are all gone.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _SUPERVISOR_H
+#define _SUPERVISOR_H
+
+#include "processes.h"
+
+#define SUP_MAX_RESTARTS	5		/* restarts of one process allowed within any one second */
+
+/* state of the session, shared by the supervisor and the three processes */
+struct session
+{
+	struct input in;			/* input process: the line being typed */
+	struct translator tr;		/* translate process: the line being translated */
+	struct render scr;			/* output process: the screen model */
+	struct history hist;		/* input process: the lines submitted so far */
+	struct sources srcs;		/* input process: the keyboard and automation sources, opened by the supervisor */
+	uint32_t echoed;			/* output process: trace ids of the keys echoed so far */
+	uint32_t chunks;			/* output process: trace ids of the writes to the screen so far */
+};
+
+/* shared session state, mapped by session_open */
+extern struct session *session;
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	session_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void session_open(void);
+--
+-- RETURNS: void
+--
+-- NOTES: Maps the shared session state and starts an empty session, opening the input sources of the options. Has
+-- to be called before the processes are created.
+--------------------------------------------------------------------------------------------------------------------*/
+void session_open(void);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	supervise
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void supervise(int pipe_in_trans[2], int pipe_in_out[2]);
+--					int pipe_in_trans[2]:	pipe from the input process to the translate process
+--					int pipe_in_out[2]: 	pipe from the input and translate processes to the output process
+--
+-- RETURNS: void, only once the session ends
+--
+-- NOTES: Creates the three processes, then waits for them and creates again any process that dies. The input
+-- process wakes it(SIGUSR1) when it accepts or drops a client, so the supervisor's copies follow. Once
+-- handle_signal has killed them to end the session, reaps all three, writes the trace file and ends the supervisor
+-- with the same signal.
+--------------------------------------------------------------------------------------------------------------------*/
+void supervise(int pipe_in_trans[2], int pipe_in_out[2]);
+
+#endif
@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	trace.c - Optional per event tracing of the three processes, written out as Chrome trace JSON
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void trace_open(void);
+--				void trace_event(int stage, int name, uint32_t id, uint64_t start);
+--				void trace_flush(const char *path);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: When tracing is turned on(-t) every key and every line is stamped with the monotonic clock and an id as it
+-- passes through the input, translate and output processes. Each process owns one ring of events in a shared
+-- mapping created before the fork, and is the only writer of that ring, so recording an event is a plain store
+-- followed by a release store of the ring head. The supervisor reads all three rings at exit and writes them
+-- to a file that can be opened in chrome://tracing or Perfetto. Only the newest TRACE_RING_SIZE events of each
+-- process are kept.
+-- A key keeps its id from the input process to its echo on the screen, and a line from the input process through
+-- the translate process to the screen. The ids travel with the messages and are counted in the shared session, so
+-- a restarted process never hands out an id twice, and the file links the events of one key or line with flow
+-- events, which the viewer draws as arrows between the processes.
+-- When tracing is off trace_rings is NULL and the TRACE macros cost a single compare.
+--------------------------------------------------------------------------------------------------------------------*/
+#include <sys/mman.h>
+
+#include "processes.h"
+#include "trace.h"
+
+struct trace_ring *trace_rings = NULL;
+
+static const char *stage_names[TRACE_STAGES] = { "input", "translate", "output" };
+static const char *event_names[] = { "key", "line", "translate", "write", "echo", "draw" };
+
+/* flow of each event: the phase that ties it to the same key or line in the other processes, and which flow */
+static const char *flow_phase[] = { "s", "s", "t", NULL, "f", "f" };
+static const int flow_line[] = { 0, 1, 1, 0, 0, 1 };
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_open(void);
+--
+-- RETURNS: void
+--
+-- NOTES: Maps the shared rings and turns tracing on. Has to be called before the processes are created.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_open(void)
+{
+	void *p = mmap(NULL, sizeof(struct trace_ring) * TRACE_STAGES, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(p == MAP_FAILED)
+		error("trace mmap()");
+	trace_rings = p;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_event
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_event(int stage, int name, uint32_t id, uint64_t start);
+--					int stage:		ring of the calling process, one of the TRACE_ values
+--					int name:		one of the EV_ values
+--					uint32_t id:	key, line or chunk number
+--					uint64_t start:	time the event started, from TRACE_NOW
+--
+-- RETURNS: void
+--
+-- NOTES: Records an event that lasted from start until now. Use the TRACE macro instead, it does nothing when
+-- tracing is off. Only the process owning the ring may call it.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_event(int stage, int name, uint32_t id, uint64_t start)
+{
+	struct trace_ring *r = &trace_rings[stage];
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	struct trace_event *e = &r->ev[head & (TRACE_RING_SIZE - 1)];
+
+	e->start = start;
+	e->dur = (uint32_t)(now_ns() - start);
+	e->name = name;
+	e->id = id;
+
+	/* publish the event to the reader */
+	atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_flush(const char *path);
+--					const char *path: file the trace is written to
+--
+-- RETURNS: void
+--
+-- NOTES: Writes the events of all three rings as Chrome trace JSON, each key and line event followed by the flow
+-- event that ties it to the same key or line in the other processes. Does nothing when tracing is off.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_flush(const char *path)
+{
+	FILE *fp;
+	const char *sep = "";
+
+	if(trace_rings == NULL || path == NULL)
+		return;
+	if((fp = fopen(path, "w")) == NULL)
+	{
+		perror("trace fopen()");
+		return;
+	}
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for(int stage = 0; stage < TRACE_STAGES; stage++)
+	{
+		struct trace_ring *r = &trace_rings[stage];
+		uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+		uint64_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+		/* one thread per process in the viewer */
+		fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				sep, stage, stage_names[stage]);
+		sep = ",\n";
+
+		for(uint64_t i = first; i < head; i++)
+		{
+			struct trace_event *e = &r->ev[i & (TRACE_RING_SIZE - 1)];
+			fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+						"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%u}}",
+					sep, event_names[e->name], stage_names[stage], stage,
+					e->start / 1000.0, e->dur / 1000.0, e->id);
+
+			/* keys and lines get separate flow ids */
+			if(flow_phase[e->name] != NULL)
+				fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",%s\"id\":%llu,\"pid\":1,\"tid\":%d,"
+							"\"ts\":%.3f}",
+						flow_line[e->name] ? "line" : "key", flow_line[e->name] ? "line" : "key",
+						flow_phase[e->name], flow_phase[e->name][0] == 'f' ? "\"bp\":\"e\"," : "",
+						(unsigned long long)e->id * 2 + flow_line[e->name], stage, e->start / 1000.0);
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+}
@@ -0,0 +1,141 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	trace.c - Optional per event tracing of the three processes, written out as Chrome trace JSON
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void trace_open(void);
+--				void trace_event(int stage, int name, uint32_t id, uint64_t start);
+--				void trace_flush(const char *path);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: When tracing is turned on(-t) every key and every line is stamped with the monotonic clock and an id as it
+-- passes through the input, translate and output processes. Each process owns one ring of events in a shared
+-- mapping created before the fork, and is the only writer of that ring, so recording an event is a plain store
+-- followed by a release store of the ring head. The supervisor reads all three rings at exit and writes them
+-- to a file that can be opened in chrome://tracing or Perfetto. Only the newest TRACE_RING_SIZE events of each
+-- process are kept.
+-- A key keeps its id from the input process to its echo on the screen, and a line from the input process through
+-- the translate process to the screen. The ids travel with the messages and are counted in the shared session, so
+-- a restarted process never hands out an id twice, and the file links the events of one key or line with flow
+-- events, which the viewer draws as arrows between the processes.
+-- When tracing is off trace_rings is NULL and the TRACE macros cost a single compare.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define TRACE_RING_SIZE	65536		/* events kept per process, power of two */
+
+/* processes, one ring each */
+#define TRACE_INPUT		0
+#define TRACE_TRANSLATE	1
+#define TRACE_OUTPUT	2
+#define TRACE_STAGES	3
+
+/* event names */
+#define EV_KEY			0			/* a key read by the input process */
+#define EV_LINE			1			/* a line written to the translate process */
+#define EV_TRANSLATE	2			/* a line translated and written to the output process */
+#define EV_WRITE		3			/* a chunk written to the screen by the output process */
+#define EV_ECHO			4			/* a key drawn by the output process */
+#define EV_DRAW			5			/* a translated line drawn by the output process */
+
+struct trace_event
+{
+	uint64_t start;		/* monotonic time in nanoseconds */
+	uint32_t dur;		/* duration in nanoseconds */
+	uint16_t name;		/* one of the EV_ values */
+	uint16_t pad;
+	uint32_t id;		/* key or line id, the same in every process, or chunk number */
+};
+
+struct trace_ring
+{
+	_Atomic uint64_t head;						/* events ever recorded */
+	struct trace_event ev[TRACE_RING_SIZE];
+};
+
+/* one ring per process in a shared mapping, NULL when tracing is off */
+extern struct trace_ring *trace_rings;
+
+/* start time of an event, 0 when tracing is off so the clock is not read */
+#define TRACE_NOW()						(trace_rings != NULL ? now_ns() : 0)
+
+/* record an event that started at start and ends now */
+#define TRACE(stage, name, id, start)	do { if(trace_rings != NULL) trace_event(stage, name, id, start); } while(0)
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_open
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_open(void);
+--
+-- RETURNS: void
+--
+-- NOTES: Maps the shared rings and turns tracing on. Has to be called before the processes are created.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_open(void);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_event
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_event(int stage, int name, uint32_t id, uint64_t start);
+--					int stage:		ring of the calling process, one of the TRACE_ values
+--					int name:		one of the EV_ values
+--					uint32_t id:	key, line or chunk number
+--					uint64_t start:	time the event started, from TRACE_NOW
+--
+-- RETURNS: void
+--
+-- NOTES: Records an event that lasted from start until now. Use the TRACE macro instead, it does nothing when
+-- tracing is off. Only the process owning the ring may call it.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_event(int stage, int name, uint32_t id, uint64_t start);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	trace_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void trace_flush(const char *path);
+--					const char *path: file the trace is written to
+--
+-- RETURNS: void
+--
+-- NOTES: Writes the events of all three rings as Chrome trace JSON, each key and line event followed by the flow
+-- event that ties it to the same key or line in the other processes. Does nothing when tracing is off.
+--------------------------------------------------------------------------------------------------------------------*/
+void trace_flush(const char *path);
+
+#endif
@@ -0,0 +1,185 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	translator.c - Reentrant, incremental translation engine, built as libtranslate.a
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void translator_init(struct translator *t);
+--				int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+--									char *out, size_t out_size, size_t *out_len);
+--				int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The translation rules of the program without any processes, pipes or globals, so the engine can be
+-- embedded in another event loop. All of the state lives in a struct translator owned by the caller, and translated
+-- lines are copied into buffers given by the caller, nothing is allocated.
+-- Keys are fed in chunks of any size. 'a' becomes 'z', 'X' deletes the previous character, 'K' deletes the whole
+-- line, 'E' ends the line, 'T' ends the session once the line is ended and ^K aborts it right away.
+--------------------------------------------------------------------------------------------------------------------*/
+#include <string.h>
+
+#include "translator.h"
+
+/* copy the current line to out and start a new one */
+static void end_line(struct translator *t, char *out, size_t out_size, size_t *out_len)
+{
+	size_t n = t->len < out_size ? t->len : out_size - 1;
+
+	if(out_size == 0)
+		n = 0;
+	else
+	{
+		memcpy(out, t->line, n);
+		out[n] = '\0';
+	}
+	*out_len = n;
+	t->len = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void translator_init(struct translator *t);
+--					struct translator *t: the context to reset
+--
+-- RETURNS: void
+--
+-- NOTES: Starts a new session with an empty line.
+--------------------------------------------------------------------------------------------------------------------*/
+void translator_init(struct translator *t)
+{
+	t->state = TR_RUNNING;
+	t->len = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_feed
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+--									char *out, size_t out_size, size_t *out_len);
+--					struct translator *t:	the context
+--					const char *data:		keys to translate
+--					size_t len:				number of keys in data
+--					size_t *used:			set to the number of keys used
+--					char *out:				buffer a finished line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut
+--					size_t *out_len:		set to the length of the line copied to out
+--
+-- RETURNS: TR_NONE, TR_LINE, TR_TERMINATE or TR_ABORT
+--
+-- NOTES: Translates keys until a line is ended or the session is over, and returns right after the key that did
+-- it. The caller feeds the rest of data (data + *used) again to get the next line. Once TR_TERMINATE or TR_ABORT
+-- was returned all keys are ignored until translator_init is called.
+--------------------------------------------------------------------------------------------------------------------*/
+int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+					char *out, size_t out_size, size_t *out_len)
+{
+	*out_len = 0;
+	if(t->state == TR_FINISHED)
+	{
+		*used = len;
+		return TR_NONE;
+	}
+
+	for(size_t i = 0; i < len; i++)
+	{
+		switch(data[i])
+		{
+			case CARRIAGE_RETURN:	/* 'E' ends the line */
+				*used = i + 1;
+				end_line(t, out, out_size, out_len);
+				if(t->state == TR_STOPPED)
+				{
+					t->state = TR_FINISHED;
+					return TR_TERMINATE;
+				}
+				return TR_LINE;
+			case ABNORM_TERM:		/* '^K' drops the line and aborts */
+				*used = i + 1;
+				t->len = 0;
+				t->state = TR_FINISHED;
+				return TR_ABORT;
+			default:
+				break;
+		}
+
+		if(t->state == TR_STOPPED)	/* everything after 'T' is ignored */
+			continue;
+
+		switch(data[i])
+		{
+			case CHAR_FROM:		/* Replace a with z */
+				if(t->len < TR_LINE_SIZE - 1)
+					t->line[t->len++] = CHAR_TO;
+				break;
+			case BACKSPACE:		/* "Delete" previous character */
+				if(t->len > 0)
+					t->len--;
+				break;
+			case LINE_KILL:		/* "Delete" all previous characters*/
+				t->len = 0;
+				break;
+			case NORM_TERM:		/* 'T' detected */
+				t->state = TR_STOPPED;
+				break;
+			default:			/* Copy char to char */
+				if(t->len < TR_LINE_SIZE - 1)
+					t->line[t->len++] = data[i];
+				break;
+		}
+	}
+	*used = len;
+	return TR_NONE;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len);
+--					struct translator *t:	the context
+--					char *out:				buffer the line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut
+--					size_t *out_len:		set to the length of the line copied to out
+--
+-- RETURNS: TR_LINE or TR_TERMINATE, TR_NONE if the session is already over
+--
+-- NOTES: Ends the current line as if 'E' had been read. Used when the input has its own line boundaries, such as
+-- a message or the end of a file.
+--------------------------------------------------------------------------------------------------------------------*/
+int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len)
+{
+	size_t used;
+	char cr = CARRIAGE_RETURN;
+
+	return translator_feed(t, &cr, 1, &used, out, out_size, out_len);
+}
@@ -0,0 +1,133 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:	translator.c - Reentrant, incremental translation engine, built as libtranslate.a
+--
+-- PROGRAM:		Asn1
+--
+-- FUNCTIONS:	void translator_init(struct translator *t);
+--				int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+--									char *out, size_t out_size, size_t *out_len);
+--				int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len);
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- NOTES: The translation rules of the program without any processes, pipes or globals, so the engine can be
+-- embedded in another event loop. All of the state lives in a struct translator owned by the caller, and translated
+-- lines are copied into buffers given by the caller, nothing is allocated.
+-- Keys are fed in chunks of any size. 'a' becomes 'z', 'X' deletes the previous character, 'K' deletes the whole
+-- line, 'E' ends the line, 'T' ends the session once the line is ended and ^K aborts it right away.
+--------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _TRANSLATOR_H
+#define _TRANSLATOR_H
+
+#include <stddef.h>
+
+#define TR_LINE_SIZE	128		/* longest line kept, including the NULL terminator */
+
+#define CHAR_FROM		0x61	/* character 'a' */
+#define CHAR_TO			0x7A	/* character 'z' */
+#define CARRIAGE_RETURN	0x45	/* character 'E' */
+#define BACKSPACE		0x58	/* character 'X' */
+#define NORM_TERM		0x54	/* character 'T' */
+#define LINE_KILL		0x4B	/* character 'K' */
+#define ABNORM_TERM		0x0B	/* character '^K' */
+
+/* events returned by translator_feed and translator_flush */
+#define TR_NONE			0		/* everything was used, no line was ended */
+#define TR_LINE			1		/* a line was ended and copied to out */
+#define TR_TERMINATE	2		/* a line containing 'T' was ended and copied to out, the session is over */
+#define TR_ABORT		3		/* ^K was read, the line was dropped and the session is over */
+
+/* translator states */
+#define TR_RUNNING		0
+#define TR_STOPPED		1		/* 'T' was read, the rest of the line is ignored */
+#define TR_FINISHED		2		/* the session is over, all input is ignored */
+
+struct translator
+{
+	int state;
+	size_t len;					/* characters in line */
+	char line[TR_LINE_SIZE];	/* translated characters of the current line */
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_init
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	void translator_init(struct translator *t);
+--					struct translator *t: the context to reset
+--
+-- RETURNS: void
+--
+-- NOTES: Starts a new session with an empty line.
+--------------------------------------------------------------------------------------------------------------------*/
+void translator_init(struct translator *t);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_feed
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+--									char *out, size_t out_size, size_t *out_len);
+--					struct translator *t:	the context
+--					const char *data:		keys to translate
+--					size_t len:				number of keys in data
+--					size_t *used:			set to the number of keys used
+--					char *out:				buffer a finished line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut
+--					size_t *out_len:		set to the length of the line copied to out
+--
+-- RETURNS: TR_NONE, TR_LINE, TR_TERMINATE or TR_ABORT
+--
+-- NOTES: Translates keys until a line is ended or the session is over, and returns right after the key that did
+-- it. The caller feeds the rest of data (data + *used) again to get the next line. Once TR_TERMINATE or TR_ABORT
+-- was returned all keys are ignored until translator_init is called.
+--------------------------------------------------------------------------------------------------------------------*/
+int translator_feed(struct translator *t, const char *data, size_t len, size_t *used,
+					char *out, size_t out_size, size_t *out_len);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION:	translator_flush
+--
+-- DATE:		October 18, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER:	agent
+--
+-- PROGRAMMER:	agent
+--
+-- INTERFACE:	int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len);
+--					struct translator *t:	the context
+--					char *out:				buffer the line is copied to, NULL terminated
+--					size_t out_size:		size of out, longer lines are cut
+--					size_t *out_len:		set to the length of the line copied to out
+--
+-- RETURNS: TR_LINE or TR_TERMINATE, TR_NONE if the session is already over
+--
+-- NOTES: Ends the current line as if 'E' had been read. Used when the input has its own line boundaries, such as
+-- a message or the end of a file.
+--------------------------------------------------------------------------------------------------------------------*/
+int translator_flush(struct translator *t, char *out, size_t out_size, size_t *out_len);
+
+#endif
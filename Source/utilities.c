@@ -9,6 +9,8 @@
 -- 				void error(char * msg);
 --				pid_t create_process(pid_t *pid);
 --				void handle_signal(int sig);
+--				void parse_options(int argc, char *argv[]);
+--				uint64_t now_ns(void);
 --
 -- DATE:		January 7, 2015
 -- 
@@ -22,6 +24,10 @@
 --
 --------------------------------------------------------------------------------------------------------------------*/
 
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
 #include "utilities.h"
 
 /*------------------------------------------------------------------------------------------------------------------ 
@@ -139,7 +145,9 @@ pid_t create_process(pid_t *pid)
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - the input process writes out the trace
+--				October 18, 2026 - processes forward the signal to the supervisor, which ends the session
+--				October 18, 2026 - the supervisor only kills the processes, supervise() finishes the session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -151,16 +159,119 @@ pid_t create_process(pid_t *pid)
 -- RETURNS: The process id
 -- 
 -- NOTES:   catch SIGTERM and SIGABRT. Send Kill() to all three proccesses running 
+--			In one of the three processes the signal is forwarded to the supervisor, a process that dies any
+--			other way is restarted. In the supervisor the handler only kills the three processes and sets
+--			end_signal, supervise() then reaps them and writes the trace file outside the handler, once no
+--			process can write to the trace rings any more
 --------------------------------------------------------------------------------------------------------------------*/
+volatile sig_atomic_t end_signal = 0;
+
 void handle_signal(int sig)
 {
-		signal(sig, NULL);
+		pid_t *ids[3] = { &id_in, &id_out, &id_trans };
+
+		/* a process asks the supervisor to end the session, then exits once the handler returns */
+		if(getpid() != id_sup)
+		{
+			signal(sig, NULL);
+			kill(id_sup, sig);
+			kill(getpid(), sig);
+			return;
+		}
+
+		/* the processes forward the signal back while they die, the session is already ending */
+		if(end_signal != 0)
+			return;
+		end_signal = sig;
+
+		/* kill all three processes, supervise() reaps them, writes the trace and ends the supervisor */
+		for(int i = 0; i < 3; i++)
+			if(*ids[i] > 0)
+				kill(*ids[i], sig);
+}
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	parse_options
+-- 
+-- DATE:		October 18, 2026
+-- 
+-- REVISIONS:	
+-- 
+-- DESIGNER:	agent
+-- 
+-- PROGRAMMER:	agent
+-- 
+-- INTERFACE:	void parse_options(int argc, char *argv[]);
+--					int argc:		number of command line arguments
+--					char *argv[]:	command line arguments
+-- 
+-- RETURNS: void
+-- 
+-- NOTES:   fill opts from the command line, print the usage and exit on an unknown option or a rate that is not
+--			a whole number of 0 or more
+--------------------------------------------------------------------------------------------------------------------*/
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-f fifo] [-s socket] [-r lines per second] [-t trace file] [-p pattern file]\n", name);
+	exit(EXIT_FAILURE);
+}
 
-		toogle_termproc(ON);
-		/* kill all three processes */
-		kill(id_in, sig);
-		kill(id_out, sig);
-		kill(id_trans, sig);
+void parse_options(int argc, char *argv[])
+{
+	int opt;
+	long rate;
+	char *end;
 
+	while((opt = getopt(argc, argv, "f:s:r:t:p:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'f':
+				opts.fifo_path = optarg;
+				break;
+			case 's':
+				opts.sock_path = optarg;
+				break;
+			case 'r':
+				/* a whole number, 0 for no limit */
+				errno = 0;
+				rate = strtol(optarg, &end, 10);
+				if(end == optarg || *end != '\0' || errno != 0 || rate < 0 || rate > INT_MAX)
+					usage(argv[0]);
+				opts.rate = (int)rate;
+				break;
+			case 't':
+				opts.trace_path = optarg;
+				break;
+			case 'p':
+				opts.subst_path = optarg;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
 }
 
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	now_ns
+-- 
+-- DATE:		October 18, 2026
+-- 
+-- REVISIONS:	
+-- 
+-- DESIGNER:	agent
+-- 
+-- PROGRAMMER:	agent
+-- 
+-- INTERFACE:	uint64_t now_ns(void);
+-- 
+-- RETURNS: the monotonic clock in nanoseconds
+-- 
+-- NOTES:   the one clock used for rate limits, restart windows and trace events, it never jumps with the wall clock
+--------------------------------------------------------------------------------------------------------------------*/
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
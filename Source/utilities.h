@@ -9,6 +9,8 @@
 -- 				void error(char * msg);
 --				pid_t create_process(pid_t *pid);
 --				void handle_signal(int sig);
+--				void parse_options(int argc, char *argv[]);
+--				uint64_t now_ns(void);
 --
 -- DATE:		January 7, 2015
 -- 
@@ -25,6 +27,8 @@
 #ifndef _UTILITIES_H
 #define _UTILITIES_H
 
+#include <stdint.h>
+
 #include "processes.h"
 
 /* For toogling terminal proccesses */
@@ -119,7 +123,9 @@ pid_t create_process(pid_t *pid);
 -- 
 -- DATE:		January 7, 2015
 -- 
--- REVISIONS:	
+-- REVISIONS:	October 18, 2026 - the input process writes out the trace
+--				October 18, 2026 - processes forward the signal to the supervisor, which ends the session
+--				October 18, 2026 - the supervisor only kills the processes, supervise() finishes the session
 -- 
 -- DESIGNER:	Ruoqi Jia
 -- 
@@ -131,8 +137,56 @@ pid_t create_process(pid_t *pid);
 -- RETURNS: The process id
 -- 
 -- NOTES:   catch SIGTERM and SIGABRT. Send Kill() to all three proccesses running 
+--			In one of the three processes the signal is forwarded to the supervisor, a process that dies any
+--			other way is restarted. In the supervisor the handler only kills the three processes and sets
+--			end_signal, supervise() then reaps them and writes the trace file outside the handler, once no
+--			process can write to the trace rings any more
 --------------------------------------------------------------------------------------------------------------------*/
 void handle_signal(int sig);
 
+/* signal that ends the session, set by handle_signal in the supervisor, 0 while the session runs */
+extern volatile sig_atomic_t end_signal;
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	parse_options
+-- 
+-- DATE:		October 18, 2026
+-- 
+-- REVISIONS:	
+-- 
+-- DESIGNER:	agent
+-- 
+-- PROGRAMMER:	agent
+-- 
+-- INTERFACE:	void parse_options(int argc, char *argv[]);
+--					int argc:		number of command line arguments
+--					char *argv[]:	command line arguments
+-- 
+-- RETURNS: void
+-- 
+-- NOTES:   fill opts from the command line, print the usage and exit on an unknown option or a rate that is not
+--			a whole number of 0 or more
+--------------------------------------------------------------------------------------------------------------------*/
+void parse_options(int argc, char *argv[]);
+
+
+/*------------------------------------------------------------------------------------------------------------------ 
+-- FUNCTION:	now_ns
+-- 
+-- DATE:		October 18, 2026
+-- 
+-- REVISIONS:	
+-- 
+-- DESIGNER:	agent
+-- 
+-- PROGRAMMER:	agent
+-- 
+-- INTERFACE:	uint64_t now_ns(void);
+-- 
+-- RETURNS: the monotonic clock in nanoseconds
+-- 
+-- NOTES:   the one clock used for rate limits, restart windows and trace events, it never jumps with the wall clock
+--------------------------------------------------------------------------------------------------------------------*/
+uint64_t now_ns(void);
 
 #endif 
\ No newline at end of file